@@ -12,15 +12,24 @@ BOOST_PYTHON_MODULE( libfs_planner )
     .def( "solve", &PythonRunner::solve )
     .def( "set_null_plan", &PythonRunner::set_null_plan)
     .def( "simulate_plan", &PythonRunner::simulate_plan)
+    .def( "rollout_batch", &PythonRunner::rollout_batch)
     .def( "get_user_option", &PythonRunner::get_user_option )
     .def( "set_user_option", &PythonRunner::set_user_option )
+    .def( "set_state_tolerance", &PythonRunner::set_state_tolerance )
     //! Read only properties
     .add_property( "plan", &PythonRunner::get_plan )
     .add_property( "plan_duration", &PythonRunner::get_plan_duration )
     .add_property( "search_time", &PythonRunner::get_search_time )
     .add_property( "setup_time", &PythonRunner::get_setup_time )
+    .add_property( "setup_breakdown", &PythonRunner::get_setup_breakdown )
     .add_property( "simulation_time", &PythonRunner::get_simulation_time )
     .add_property( "result", &PythonRunner::get_result )
+    .add_property( "plan_cache_hits", &PythonRunner::get_plan_cache_hits )
+    .add_property( "plan_cache_misses", &PythonRunner::get_plan_cache_misses )
+    .add_property( "plan_cache_rejections", &PythonRunner::get_plan_cache_rejections )
+    .add_property( "num_plan_reuses", &PythonRunner::get_num_plan_reuses )
+    .add_property( "num_plan_extensions", &PythonRunner::get_num_plan_extensions )
+    .add_property( "num_full_searches", &PythonRunner::get_num_full_searches )
     //! Read write properties
     .add_property( "timeout", &PythonRunner::get_timeout, &PythonRunner::set_timeout)
     .add_property( "data_dir", &PythonRunner::get_data_dir, &PythonRunner::set_data_dir)
@@ -33,6 +42,17 @@ BOOST_PYTHON_MODULE( libfs_planner )
     .add_property( "budget", &PythonRunner::get_budget, &PythonRunner::set_budget)
     .add_property( "verify_plan", &PythonRunner::get_verify_plan, &PythonRunner::set_verify_plan)
     .add_property( "external_lib", &PythonRunner::get_external_lib, &PythonRunner::set_external_lib)
+    .add_property( "plan_cache_size", &PythonRunner::get_plan_cache_size, &PythonRunner::set_plan_cache_size)
+    .add_property( "plan_cache_tolerance", &PythonRunner::get_plan_cache_tolerance, &PythonRunner::set_plan_cache_tolerance)
+    .add_property( "plan_cache_threshold", &PythonRunner::get_plan_cache_threshold, &PythonRunner::set_plan_cache_threshold)
+    .add_property( "incremental_replanning", &PythonRunner::get_incremental_replanning, &PythonRunner::set_incremental_replanning)
+    .add_property( "replanning_min_steps", &PythonRunner::get_replanning_min_steps, &PythonRunner::set_replanning_min_steps)
+    .add_property( "replanning_threshold", &PythonRunner::get_replanning_threshold, &PythonRunner::set_replanning_threshold)
+    .add_property( "clock_variable", &PythonRunner::get_clock_variable, &PythonRunner::set_clock_variable)
+    .add_property( "schedule_fine_depth", &PythonRunner::get_schedule_fine_depth, &PythonRunner::set_schedule_fine_depth)
+    .add_property( "schedule_growth", &PythonRunner::get_schedule_growth, &PythonRunner::set_schedule_growth)
+    .add_property( "schedule_max_step", &PythonRunner::get_schedule_max_step, &PythonRunner::set_schedule_max_step)
+    .add_property( "rollout_threads", &PythonRunner::get_rollout_threads, &PythonRunner::set_rollout_threads)
 
     ; //! Note the semi colon!
 }
@@ -9,13 +9,20 @@
 #include <fs/core/languages/fstrips/operations.hxx>
 #include <fs/core/search/drivers/setups.hxx>
 #include <search/drivers/online/registry.hxx>
+#include <search/drivers/online/rewards.hxx>
+#include <utils/thread_pool.hxx>
 #include <cstring>
+#include <cmath>
+#include <chrono>
+#include <future>
+#include <mutex>
 #include <rapidjson/document.h>
 #include <fs/core/fstrips/loader.hxx>
 #include <fs/core/utils/loader.hxx>
 #include <fs/core/utils/component_factory.hxx>
 
 #include <dlfcn.h> // For run-time symbol loading in Linux
+#include <Python.h> // For releasing the GIL
 
 #include <locale>
 #include <codecvt>
@@ -44,18 +51,55 @@ fs0::Problem* generate(const rapidjson::Document& data, const std::string& data_
 
 namespace fs0 { namespace drivers {
 
+namespace {
+//! Releases the Python global interpreter lock for the lifetime of the object
+class ReleaseGIL {
+    PyThreadState* _state;
+public:
+    ReleaseGIL() : _state(PyEval_SaveThread()) {}
+    ~ReleaseGIL() { PyEval_RestoreThread(_state); }
+};
+
+//! The planner singletons are global, so only one runner at a time can have them installed.
+//! This only matters while rollout_batch() releases the GIL, since otherwise Python threads
+//! cannot run planner code concurrently anyway.
+std::mutex singletons_mutex;
+
+//! Waits for the singletons without holding the GIL, which their current holder may need to finish
+std::unique_lock<std::mutex> lock_singletons() {
+    std::unique_lock<std::mutex> lock( singletons_mutex, std::try_to_lock );
+    if ( !lock.owns_lock() ) {
+        ReleaseGIL release;
+        lock.lock();
+    }
+    return lock;
+}
+
+//! Makes 's' the initial state of the problem for the lifetime of the object, and then restores 'restore'
+class InitialStateOverride {
+    const State& _restore;
+public:
+    InitialStateOverride( const State& s, const State& restore ) : _restore(restore) { Problem::getInstance().setInitialState( s ); }
+    ~InitialStateOverride() { Problem::getInstance().setInitialState( _restore ); }
+    InitialStateOverride( const InitialStateOverride& ) = delete;
+    InitialStateOverride& operator=( const InitialStateOverride& ) = delete;
+};
+}
+
 class SingletonLock {
+    std::unique_lock<std::mutex> _lock;
     PythonRunner& _runner;
 
 public:
     SingletonLock( PythonRunner& r )
-        : _runner(r) {
+        : _lock(lock_singletons()), _runner(r) {
             lapkt::tools::Logger::set_instance( std::move(_runner._logger));
 			LogicalComponentRegistry::set_instance( std::move( _runner._registry ));
             fstrips::LanguageInfo::setInstance( std::move(_runner._lang_info ));
             ProblemInfo::setInstance( std::move(_runner._problem_info));
             Problem::setInstance( std::move(_runner._problem) );
             Config::setAsGlobal( std::move(_runner._instance_config) );
+            ExternalBatchEvaluator::set_instance( std::move(_runner._external_batch) );
         }
 
     ~SingletonLock() {
@@ -65,6 +109,7 @@ public:
         _runner._instance_config = Config::claimOwnership();
 		_runner._registry = LogicalComponentRegistry::claim_ownership();
         _runner._logger = lapkt::tools::Logger::claim_ownership();
+        _runner._external_batch = ExternalBatchEvaluator::claim_ownership();
     }
 };
 
@@ -82,7 +127,22 @@ PythonRunner::PythonRunner() :
     _current_driver( nullptr ),
     _state(nullptr),
     _state_model(nullptr),
-	_external_dll_handle(nullptr) {
+	_external_dll_handle(nullptr),
+    _external_batch_function(nullptr),
+    _plan_cache_threshold( 0.0 ),
+    _rollout(nullptr),
+    _incremental_replanning( false ),
+    _replanning_min_steps( 0 ),
+    _replanning_threshold( 0.0 ),
+    _clock_variable( "clock_time()" ),
+    _last_plan_state(nullptr),
+    _num_plan_reuses( 0 ),
+    _num_plan_extensions( 0 ),
+    _num_full_searches( 0 ),
+    _schedule_fine_depth( -1 ),
+    _schedule_growth( 2.0 ),
+    _schedule_max_step( 0.0 ),
+    _rollout_threads( 1 ) {
 
 }
 
@@ -104,6 +164,23 @@ PythonRunner::PythonRunner( const PythonRunner& other ) {
     _state = nullptr;
     _state_model = nullptr;
 	_external_dll_handle = nullptr;
+    _external_batch_function = nullptr;
+    _setup_stages = other._setup_stages;
+    _plan_cache = online::PlanCache(other._plan_cache.capacity(), other._plan_cache.default_tolerance());
+    _plan_cache_threshold = other._plan_cache_threshold;
+    _rollout = nullptr;
+    _incremental_replanning = other._incremental_replanning;
+    _replanning_min_steps = other._replanning_min_steps;
+    _replanning_threshold = other._replanning_threshold;
+    _clock_variable = other._clock_variable;
+    _last_plan_state = nullptr;
+    _num_plan_reuses = 0;
+    _num_plan_extensions = 0;
+    _num_full_searches = 0;
+    _schedule_fine_depth = other._schedule_fine_depth;
+    _schedule_growth = other._schedule_growth;
+    _schedule_max_step = other._schedule_max_step;
+    _rollout_threads = other._rollout_threads;
 }
 
 PythonRunner::~PythonRunner() {
@@ -114,6 +191,10 @@ PythonRunner::~PythonRunner() {
 	if ( _external_dll_handle == nullptr )
 		return;
 
+	_external_batch = nullptr;
+	// If setup() failed after registering the external components, the global ProblemInfo still
+	// holds an instance created by the library, which must then stay loaded
+	if ( _problem_info == nullptr ) return;
 	ExternalI* ex = _problem_info->release_external();
 	_external_destructor(ex);
 	dlclose(_external_dll_handle);
@@ -155,7 +236,7 @@ PythonRunner::report_stats(const Problem& problem, const std::string& out_dir) {
 }
 
 void
-PythonRunner::load_external_symbols( ProblemInfo& info ) {
+PythonRunner::open_external_library() {
 	if (_external_dll_name.empty()) return;
 	if ( _external_dll_handle != nullptr )
 		throw std::runtime_error("[PythonRunner::load_external_symbols] : Already associated with an external dll!");
@@ -172,7 +253,7 @@ PythonRunner::load_external_symbols( ProblemInfo& info ) {
 	_external_creator = func_ptr;
 	const char *dlsym_error = dlerror();
 	if (dlsym_error != nullptr) {
-		dlclose(_external_dll_handle);
+		close_external_library();
 		throw std::runtime_error("[PythonRunner::load_external_symbols] : Cannot load symbol 'create_instance' " + std::string(dlsym_error));
 	}
 	dlerror(); // Clear error state
@@ -182,13 +263,39 @@ PythonRunner::load_external_symbols( ProblemInfo& info ) {
 	_external_destructor = des_func_ptr;
 	dlsym_error = dlerror();
 	if (dlsym_error != nullptr) {
-		dlclose(_external_dll_handle);
+		close_external_library();
 		throw std::runtime_error("[PythonRunner::load_external_symbols] : Cannot load symbol 'destroy_instance' " + std::string(dlsym_error));
 	}
+	// The batched calling convention is optional
+	dlerror(); // Clear error state
+	ExternalBatchSignature batch_func_ptr;
+	*reinterpret_cast<void**>(&batch_func_ptr) = dlsym(_external_dll_handle, ExternalBatchEvaluator::symbol_name());
+	dlsym_error = dlerror();
+	if (dlsym_error != nullptr) batch_func_ptr = nullptr;
+	_external_batch_function = batch_func_ptr;
+}
+
+void
+PythonRunner::close_external_library() {
+	if ( _external_dll_handle == nullptr ) return;
+	dlclose(_external_dll_handle);
+	_external_dll_handle = nullptr;
+	_external_batch_function = nullptr;
+}
+
+void
+PythonRunner::load_external_symbols( ProblemInfo& info ) {
+	if (_external_dll_name.empty()) return;
+	if ( _external_dll_handle == nullptr ) open_external_library();
+	ExternalBatchSignature batch_func_ptr = _external_batch_function;
 	// and finally we're ready
 	std::unique_ptr<ExternalI> external = std::unique_ptr<ExternalI>(_external_creator(info, _options.getDataDir()));
 	LPT_INFO("main", "[PythonRunner::load_external_symbols] : Registering external components from library '"<< _external_dll_name << "'");
 	external->registerComponents();
+	if ( batch_func_ptr != nullptr ) {
+		LPT_INFO("main", "[PythonRunner::load_external_symbols] : Library supports batched evaluation ('" << ExternalBatchEvaluator::symbol_name() << "')");
+		ExternalBatchEvaluator::set_instance( std::make_unique<ExternalBatchEvaluator>(external.get(), batch_func_ptr) );
+	}
 	info.set_external(std::move(external));
 
 }
@@ -217,12 +324,26 @@ PythonRunner::update( Config& config ) {
     LPT_INFO("main", "Planner configuration: " << std::endl << config);
 }
 
+namespace {
+using Clock = std::chrono::steady_clock;
+
+double seconds_since( Clock::time_point t0 ) {
+    return std::chrono::duration<double>( Clock::now() - t0 ).count();
+}
+}
+
 void
 PythonRunner::setup() {
     if (_current_driver != nullptr )
         throw std::runtime_error("[PythonRunner::setup] was called twice on the same object" ) ;
-    /* code */
-    float t0 = aptk::time_used();
+    // The singletons are installed below without a SingletonLock, but other runners must still wait for them
+    std::unique_lock<std::mutex> singletons = lock_singletons();
+    // Stages which do not depend on each other are overlapped, so the times of the stages are wall-clock
+    // times, while setup_time is still the CPU time of the whole setup
+    float cpu_t0 = aptk::time_used();
+    Clock::time_point t0 = Clock::now();
+    Clock::time_point t_stage = t0;
+    _setup_stages.clear();
 
     _logger = std::make_unique<lapkt::tools::Logger>(_options.getOutputDir() + "/logs");
     lapkt::tools::Logger::set_instance(std::move(_logger));
@@ -233,24 +354,61 @@ PythonRunner::setup() {
     Config::setAsGlobal( std::move(_instance_config) );
 
 	fs0::LogicalComponentRegistry::set_instance( std::make_unique<fs0::LogicalComponentRegistry>());
+    _setup_stages.emplace_back( "configuration", seconds_since(t_stage) );
 
+    // Parsing the problem specification and opening the external library only need the file
+    // system, so they run in the background while the language is being loaded
     LPT_INFO("main", "[PythonRunner::setup] Generating the problem (" << _options.getDataDir() << ")... ");
-    //! This will generate the problem and set it as the global singleton instance
     const std::string problem_spec = _options.getDataDir() + "/problem.json";
-    auto data = Loader::loadJSONObject( problem_spec);
+    double json_time = 0.0, library_time = 0.0;
+    auto json_task = std::async( std::launch::async, [&problem_spec, &json_time]() {
+        Clock::time_point t = Clock::now();
+        auto data = Loader::loadJSONObject( problem_spec);
+        json_time = seconds_since(t);
+        return data;
+    });
+    auto library_task = std::async( std::launch::async, [this, &library_time]() {
+        Clock::time_point t = Clock::now();
+        open_external_library();
+        library_time = seconds_since(t);
+    });
+
+    // Until the external components are registered, nothing else refers to the library, so it is
+    // closed again if any of the stages it overlaps with fails
+    struct CloseLibraryOnFailure {
+        PythonRunner& runner;
+        std::future<void>& task;
+        bool dismissed;
+        ~CloseLibraryOnFailure() {
+            if ( dismissed ) return;
+            if ( task.valid() ) task.wait();
+            runner.close_external_library();
+        }
+    } library_guard{ *this, library_task, false };
+
+    //! This will generate the problem and set it as the global singleton instance
+    auto data = json_task.get();
+    _setup_stages.emplace_back( "parsing", json_time );
     LPT_INFO("main", "[PythonRunner::setup] Loaded JSON specification from '" << problem_spec << "'... ");
 
     fs0::BaseComponentFactory factory;
 
+    t_stage = Clock::now();
     LPT_INFO( "main", "[PythonRunner::setup] Loading language info...")
     fs0::fstrips::LanguageJsonLoader::loadLanguageInfo(data);
 
     LPT_INFO( "main", "[PythonRunner::setup] Loading problem info...")
     auto& info = fs0::Loader::loadProblemInfo(data, _options.getDataDir(), factory);
+    _setup_stages.emplace_back( "problem_info", seconds_since(t_stage) );
 
 	//MRJ: placement of this function matters - depends on ProblemInfo being setup
+    library_task.get();
+    t_stage = Clock::now();
 	load_external_symbols(info);
+    library_guard.dismissed = true;
+    _setup_stages.emplace_back( "external", library_time + seconds_since(t_stage) );
 
+    t_stage = Clock::now();
     LPT_INFO( "main", "[PythonRunner::setup] Loading problem...");
     auto problem = fs0::Loader::loadProblem(data);
 
@@ -260,20 +418,36 @@ PythonRunner::setup() {
     LPT_INFO("main", "[PythonRunner::setup] Problem instance loaded" );
     report_stats( *problem, _options.getOutputDir() );
     update( config );
+    _setup_stages.emplace_back( "problem", seconds_since(t_stage) );
 
+    t_stage = Clock::now();
     LPT_INFO("main", "[PythonRunner::setup] Grounding Actions....");
     _problem = Problem::claimOwnership();
     _state_model = std::make_shared<SimpleStateModel>(drivers::GroundingSetup::fully_ground_simple_model(*_problem));
 	Problem::setInstance(std::move(_problem));
-    LPT_INFO("main", "[PythonRunner::setup] Indexing state variables..." );
-    index_state_variables();
+    _setup_stages.emplace_back( "grounding", seconds_since(t_stage) );
+
     std::string option_value = Config::instance().getOption<bool>("dynamics.decompose_ode", false) ? "yes" : "no";
     LPT_INFO( "main", "[PythonRunner::setup] Decomposing ODEs?: " << option_value);
     LPT_INFO("main", "[PythonRunner::setup] Preparing Search Engine....");
+    t_stage = Clock::now();
     _current_driver = _available_engines.get(_options.getDriver());
     _current_driver->prepare(*_state_model, config, _options.getOutputDir());
-    _setup_time = aptk::time_used() - t0;
-    LPT_INFO("main", "[PythonRunner::setup] Finished!" );
+    _setup_stages.emplace_back( "driver", seconds_since(t_stage) );
+
+    t_stage = Clock::now();
+    LPT_INFO("main", "[PythonRunner::setup] Indexing state variables..." );
+    index_state_variables();
+    _rollout = std::make_shared<online::PlanRollout>(*_state_model, online::RewardFunctionFactory::create(config, Problem::getInstance()),
+                                                        online::RewardFunctionFactory::create_batch(config, ProblemInfo::getInstance()));
+    _rollout_models.clear();
+    _setup_stages.emplace_back( "indexing", seconds_since(t_stage) );
+
+    _setup_time = aptk::time_used() - cpu_t0;
+    for ( const auto& stage : _setup_stages )
+        LPT_INFO("main", "[PythonRunner::setup] Stage '" << stage.first << "': " << stage.second << " secs" );
+    _setup_stages.emplace_back( "wall_clock", seconds_since(t0) );
+    LPT_INFO("main", "[PythonRunner::setup] Finished in " << _setup_stages.back().second << " secs (CPU time: " << _setup_time << " secs)" );
     // Singleton management: note that we're not using the Lock class because
     // the pointers are initialised during this method
     _lang_info = fstrips::LanguageInfo::claimOwnership();
@@ -282,6 +456,15 @@ PythonRunner::setup() {
     _instance_config = Config::claimOwnership();
     _logger = lapkt::tools::Logger::claim_ownership();
 	_registry = LogicalComponentRegistry::claim_ownership();
+    _external_batch = ExternalBatchEvaluator::claim_ownership();
+}
+
+bp::dict
+PythonRunner::get_setup_breakdown() {
+    bp::dict stages;
+    for ( const auto& stage : _setup_stages )
+        stages[stage.first] = stage.second;
+    return stages;
 }
 
 void
@@ -296,7 +479,14 @@ PythonRunner::set_initial_state( bp::dict& new_state ) {
         throw std::runtime_error("[PythonRunner::set_initial_state] Error: before setting states it is necessary to setup the planner");
     }
     SingletonLock lock(*this);
-    _state = std::make_shared<State>(Problem::getInstance().getInitialState());
+    _state = parse_state( new_state );
+    LPT_INFO("search", "Initial state set:" << *_state );
+
+}
+
+std::shared_ptr<State>
+PythonRunner::parse_state( bp::dict& new_state ) {
+    auto state = std::make_shared<State>(Problem::getInstance().getInitialState());
     const ProblemInfo& info = ProblemInfo::getInstance();
     const bp::list& entries = new_state.items();
 
@@ -308,7 +498,7 @@ PythonRunner::set_initial_state( bp::dict& new_state ) {
 
         auto it = _var_index.find(var_name);
         if (it == _var_index.end()) {
-            throw std::runtime_error( "Error: PythonRunner::set_initial_state : unknown variable found in state: " + var_name );
+            throw std::runtime_error( "Error: PythonRunner::parse_state : unknown variable found in state: " + var_name );
         }
         VariableIdx var = it->second;
         object_id value;
@@ -333,14 +523,13 @@ PythonRunner::set_initial_state( bp::dict& new_state ) {
 			value =  info.get_object_id(obj_name);
 		}
 		else {
-			throw std::runtime_error("PythonRunner::set_initial_state() : Cannot load state variable '" + info.getVariableName(var)
+			throw std::runtime_error("PythonRunner::parse_state() : Cannot load state variable '" + info.getVariableName(var)
 									 + "' of type '" + fstrips::LanguageInfo::instance().get_typename(var) + "'");
 		}
         facts.push_back( Atom( var, value ));
     }
-    _state->accumulate(facts);
-    LPT_INFO("search", "Initial state set:" << *_state );
-
+    state->accumulate(facts);
+    return state;
 }
 
 bp::dict
@@ -373,15 +562,127 @@ PythonRunner::solve() {
     _problem->setInitialState( *_state );
     SingletonLock lock(*this);
     float t0 = aptk::time_used();
-    //Config& config = Config::instance();
-    //ExitCode code = _current_driver->search(*_state_model, config, _options.getOutputDir(), 0.0f);
-    /*ExitCode code =*/ _current_driver->search();
-    _current_driver->archive_results_JSON( "results.json" );
-    _native_plan.interpret_plan( _current_driver->plan );
+    online::PlanCache::KeyT key;
+    online::PlanCache::PlanT plan;
+    if ( _plan_cache.enabled() )
+        key = _plan_cache.quantise( *_state, ProblemInfo::getInstance() );
+    bool full_search = false;
+    if ( !solve_from_plan_cache( key, plan ) && !solve_incrementally( plan ) ) {
+        //Config& config = Config::instance();
+        //ExitCode code = _current_driver->search(*_state_model, config, _options.getOutputDir(), 0.0f);
+        /*ExitCode code =*/ _current_driver->search();
+        _current_driver->archive_results_JSON( "results.json" );
+        plan = _current_driver->plan;
+        _num_full_searches++;
+        full_search = true;
+    }
+    if ( _plan_cache.enabled() || _incremental_replanning ) {
+        // Both the plan cache and incremental replanning need the rewards of the plan, so we replay it once for both
+        online::RolloutResult outcome = _rollout->run( *_state, plan );
+        if ( full_search ) store_in_plan_cache( key, plan, outcome );
+        remember_plan( plan, outcome );
+    }
+    _native_plan.interpret_plan( plan );
     export_plan();
     _search_time = aptk::time_used() - t0;
 }
 
+bool
+PythonRunner::solve_from_plan_cache( const online::PlanCache::KeyT& key, online::PlanCache::PlanT& plan ) {
+    if ( !_plan_cache.enabled() ) return false;
+    const online::PlanCache::Entry* entry = _plan_cache.find( key );
+    if ( entry == nullptr ) return false;
+
+    // The cached plan was computed for a state which is only approximately equal to the current one,
+    // so we check by simulation that it is still applicable and as good as it was back then.
+    online::RolloutResult outcome = _rollout->run( *_state, entry->plan );
+    bool valid = outcome.valid && outcome.reward() >= entry->reward - _plan_cache_threshold;
+    _plan_cache.validated( valid );
+    LPT_INFO("main", "[PythonRunner::solve] Plan cache hit: valid=" << outcome.valid << ", R=" << outcome.reward()
+                        << ", cached R=" << entry->reward << ", accepted? " << (valid ? "yes" : "no"));
+    if ( !valid ) return false;
+    plan = entry->plan;
+    return true;
+}
+
+void
+PythonRunner::store_in_plan_cache( const online::PlanCache::KeyT& key, const online::PlanCache::PlanT& plan, const online::RolloutResult& outcome ) {
+    if ( !_plan_cache.enabled() || !outcome.valid ) return;
+    _plan_cache.put( key, online::PlanCache::Entry{ plan, outcome.reward() } );
+}
+
+bool
+PythonRunner::solve_incrementally( online::PlanCache::PlanT& plan ) {
+    if ( !_incremental_replanning || _last_plan_state == nullptr || _last_plan.empty() ) return false;
+    auto it = _var_index.find(_clock_variable);
+    if ( it == _var_index.end() )
+        throw std::runtime_error( "[PythonRunner::solve] : incremental replanning requires a clock, but '" + _clock_variable + "' is not a state variable" );
+
+    // Work out how many control steps of the last plan have been executed since it was computed
+    float elapsed = fs0::value<float>(_state->getValue(it->second)) - fs0::value<float>(_last_plan_state->getValue(it->second));
+    if ( elapsed < 0.0f || _time_step <= 0.0 ) return false;
+    unsigned k = std::lround( elapsed / _time_step );
+    if ( k >= _last_plan.size() ) return false;
+
+    // Replay the remainder from the new state, stopping at the first action that is no longer applicable,
+    // and check that the reward collected is on par with the one that was expected for the same steps.
+    online::RolloutResult outcome = _rollout->run( *_state, _last_plan, k );
+    if ( outcome.steps == 0 ) return false;
+    float expected = 0.0f, achieved = 0.0f;
+    for ( unsigned i = 0; i <= outcome.steps; i++ ) {
+        expected += _last_plan_rewards[k + i];
+        achieved += outcome.step_rewards[i];
+    }
+    if ( achieved < expected - _replanning_threshold ) {
+        LPT_INFO("main", "[PythonRunner::solve] Remainder of last plan rejected: R=" << achieved << ", expected R=" << expected);
+        return false;
+    }
+    plan.assign( _last_plan.begin() + k, _last_plan.begin() + k + outcome.steps );
+
+    // By default, the remainder is reused as is while it still covers half of the lookahead horizon
+    unsigned min_steps = _replanning_min_steps;
+    if ( min_steps == 0 ) min_steps = std::max( 1l, std::lround( std::ceil( _time_horizon / _time_step ) / 2.0 ) );
+    if ( plan.size() >= min_steps ) {
+        LPT_INFO("main", "[PythonRunner::solve] Reusing " << plan.size() << " steps of the last plan");
+        _num_plan_reuses++;
+        return true;
+    }
+
+    // The remainder is valid but too short, so we spend the lookahead on extending it from its last state
+    LPT_INFO("main", "[PythonRunner::solve] Extending " << plan.size() << " steps of the last plan");
+    ExitCode code;
+    {
+        InitialStateOverride initial_state( *outcome.final_state, *_state );
+        code = _current_driver->search();
+    }
+    _current_driver->archive_results_JSON( "results.json" );
+    if ( code != ExitCode::PLAN_FOUND ) {
+        LPT_INFO("main", "[PythonRunner::solve] Could not extend the last plan, searching from scratch");
+        plan.clear();
+        return false;
+    }
+    plan.insert( plan.end(), _current_driver->plan.begin(), _current_driver->plan.end() );
+    _num_plan_extensions++;
+    return true;
+}
+
+void
+PythonRunner::remember_plan( const online::PlanCache::PlanT& plan, const online::RolloutResult& outcome ) {
+    if ( !_incremental_replanning ) return;
+    _last_plan.assign( plan.begin(), plan.begin() + outcome.steps );
+    _last_plan_rewards = outcome.step_rewards;
+    _last_plan_state = std::make_shared<State>( *_state );
+}
+
+void
+PythonRunner::set_state_tolerance( std::string var_name, double tol ) {
+    auto it = _var_index.find(var_name);
+    if (it == _var_index.end()) {
+        throw std::runtime_error( "Error: PythonRunner::set_state_tolerance : unknown state variable: " + var_name + " (was the planner setup?)" );
+    }
+    _plan_cache.set_tolerance( it->second, tol );
+}
+
 
 void
 PythonRunner::export_plan( ) {
@@ -614,4 +915,104 @@ PythonRunner::simulate_plan( double duration, double step_size ) {
     return py_trace;
 }
 
+online::PlanRollout::ActionIdT
+PythonRunner::action_id( const std::string& name ) {
+    if ( _action_index.empty() ) {
+        for ( const GroundAction* a : Problem::getInstance().getGroundActions() )
+            _action_index[a->getName()] = a->getId();
+    }
+    auto it = _action_index.find(name);
+    if ( it == _action_index.end() )
+        throw std::runtime_error("[PythonRunner::rollout_batch] : unknown action '" + name + "'");
+    return it->second;
+}
+
+bp::dict
+PythonRunner::rollout_batch( bp::list initial_states, bp::list plans, double duration, double step ) {
+    if ( _problem == nullptr )
+        throw std::runtime_error("[PythonRunner::rollout_batch] : before simulating plans it is necessary to setup the planner");
+    SingletonLock lock(*this);
+    // Process CPU time would add up the time of all the workers, so the batch is timed by the wall clock
+    Clock::time_point t0 = Clock::now();
+
+    // Decode all the inputs while we hold the GIL
+    const unsigned num_plans = bp::len(plans);
+    const unsigned num_states = bp::len(initial_states);
+    if ( num_states != 1 && num_states != num_plans )
+        throw std::runtime_error("[PythonRunner::rollout_batch] : expected either one initial state or one per plan, got "
+                                 + std::to_string(num_states) + " states for " + std::to_string(num_plans) + " plans");
+    std::vector<std::shared_ptr<State>> states;
+    for ( unsigned i = 0; i < num_states; i++ ) {
+        bp::dict py_s = bp::extract<bp::dict>(initial_states[i]);
+        states.push_back( parse_state(py_s) );
+    }
+    // Plans are lists of action names, or of (timing, action name) pairs as exported in 'plan'
+    std::vector<online::PlanRollout::PlanT> native_plans(num_plans);
+    for ( unsigned i = 0; i < num_plans; i++ ) {
+        bp::list py_plan = bp::extract<bp::list>(plans[i]);
+        for ( unsigned k = 0; k < bp::len(py_plan); k++ ) {
+            bp::object entry = py_plan[k];
+            bp::extract<bp::tuple> as_pair(entry);
+            bp::object name = as_pair.check() ? bp::object(as_pair()[1]) : entry;
+            native_plans[i].push_back( action_id( bp::extract<std::string>(bp::str(name).encode("utf-8")) ) );
+        }
+    }
+
+    // Each action lasts one discretization step
+    unsigned max_steps = std::numeric_limits<unsigned>::max();
+    if ( duration > 0.0 && _time_step > 0.0 ) max_steps = std::floor( duration / _time_step + 1e-6 );
+    unsigned sample_every = 0;
+    if ( step > 0.0 && _time_step > 0.0 ) sample_every = std::max( 1l, std::lround( step / _time_step ) );
+
+    std::vector<online::RolloutResult> results(num_plans);
+    if ( _rollout_threads == 1 ) {
+        // By default, rollouts are run in sequence by the calling thread, which keeps the GIL
+        for ( unsigned i = 0; i < num_plans; i++ )
+            results[i] = _rollout->run_sampled( *states[ num_states == 1 ? 0 : i ], native_plans[i], max_steps, sample_every );
+    } else {
+        if ( _rollout_pool == nullptr || ( _rollout_threads > 0 && _rollout_pool->size() != _rollout_threads ) ) {
+            _rollout_pool = std::make_unique<ThreadPool>( _rollout_threads );
+            _rollout_models.clear();
+        }
+        // Every worker replays plans over its own model and scores them with its own reward functions,
+        // as these may keep internal buffers
+        while ( _rollout_models.size() < _rollout_pool->size() )
+            _rollout_models.push_back( std::make_shared<SimpleStateModel>( drivers::GroundingSetup::fully_ground_simple_model( Problem::getInstance() ) ) );
+        std::vector<online::PlanRollout> rollouts;
+        rollouts.reserve( _rollout_pool->size() );
+        for ( unsigned w = 0; w < _rollout_pool->size(); w++ )
+            rollouts.emplace_back( *_rollout_models[w], online::RewardFunctionFactory::create( Config::instance(), Problem::getInstance() ),
+                                    online::RewardFunctionFactory::create_batch( Config::instance(), ProblemInfo::getInstance() ) );
+
+        // The singletons stay installed while the GIL is released, other runners wait for them in SingletonLock
+        ReleaseGIL release;
+        _rollout_pool->parallel_for( num_plans, [&]( std::size_t i, unsigned worker ) {
+            const State& s0 = *states[ num_states == 1 ? 0 : i ];
+            results[i] = rollouts[worker].run_sampled( s0, native_plans[i], max_steps, sample_every );
+        });
+    }
+
+    const ProblemInfo& info = ProblemInfo::getInstance();
+    bp::list py_final_states, py_rewards, py_valid, py_steps, py_trajectories;
+    for ( const auto& result : results ) {
+        py_final_states.append( decode_state( *result.final_state, info ) );
+        py_rewards.append( result.reward() );
+        py_valid.append( result.valid );
+        py_steps.append( result.steps );
+        if ( sample_every == 0 ) continue;
+        bp::list py_trace;
+        for ( const auto& s_k : result.trajectory )
+            py_trace.append( decode_state( *s_k, info ) );
+        py_trajectories.append( py_trace );
+    }
+    bp::dict py_results;
+    py_results["final_states"] = py_final_states;
+    py_results["rewards"] = py_rewards;
+    py_results["valid"] = py_valid;
+    py_results["steps"] = py_steps;
+    if ( sample_every > 0 ) py_results["trajectories"] = py_trajectories;
+    _simulation_time = seconds_since(t0);
+    return py_results;
+}
+
 }}
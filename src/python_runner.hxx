@@ -9,11 +9,15 @@
 #include <fs/core/models/simple_state_model.hxx>
 #include <fs/core/search/drivers/base.hxx>
 #include <search/drivers/online/registry.hxx>
+#include <search/drivers/online/plan_cache.hxx>
+#include <search/drivers/online/plan_rollout.hxx>
 #include <fs/core/search/runner.hxx>
 #include <fs/core/search/options.hxx>
 #include <fs/core/utils/config.hxx>
 #include <fs/core/utils/external.hxx>
 #include <fs/hybrid/dynamics/hybrid_plan.hxx>
+#include <utils/external_batch.hxx>
+#include <utils/thread_pool.hxx>
 // This include will dinamically point to the adequate per-instance automatically generated file
 #include <boost/python.hpp>
 #include <rapidjson/document.h>
@@ -51,6 +55,8 @@ public:
     //typedef std::function<ExternalI* (const ProblemInfo& info, const std::string&)> ExternalCreatorFunction;
     typedef std::function<ExternalI* (const ProblemInfo& info, const std::string&)> ExternalCreatorFunction;
     typedef std::function<void(ExternalI*)> ExternalDestructorFunction;
+    //! The type of the (optional) batched evaluation entry point of external modules
+    typedef ExternalBatchEvaluator::SignatureT ExternalBatchSignature;
 
 
     PythonRunner();
@@ -68,8 +74,11 @@ public:
 
     //! plan - read only, contains the last plan computed
     bp::list   get_plan() { return _plan; }
-    //! setup_time - read only, time to setup the planner (in seconds)
+    //! setup_time - read only, CPU time to setup the planner (in seconds)
     double      get_setup_time( ) { return _setup_time; }
+    //! setup_breakdown - read only, wall-clock time taken by each stage of the setup (in seconds), and by the
+    //! whole setup ('wall_clock'). Parsing and opening the external library overlap, so the stages can add up to more
+    bp::dict    get_setup_breakdown();
     //! search_time - read only, time spent searching for a plan
     double      get_search_time() { return _search_time; }
     //! plan duration - read only, plan duration in time units
@@ -108,16 +117,75 @@ public:
     void        set_budget( unsigned B) { _budget = B; }
     //! simulate_plan - simulates the plan found (useful for visualization and debugging)
     bp::list    simulate_plan( double duration, double step_size );
+    //! simulation_time - read only, time taken by the last call to simulate_plan (CPU time) or rollout_batch (wall-clock time)
     double      get_simulation_time() { return _simulation_time; }
+    //! rollout_batch - replays each of the given plans (lists of action names, or of (timing, action name) pairs)
+    //! from the corresponding initial state (or from a single state shared by all) for at most 'duration' time units.
+    //! Returns a dict with the final states, accumulated rewards, validity and number of actions applied of each
+    //! rollout, plus their trajectories sampled every 'step' time units if 'step' is positive.
+    //! With rollout_threads = 1 (the default) rollouts run in sequence while holding the GIL. Otherwise they run
+    //! in parallel with the GIL released, each worker with its own state model and reward functions, but sharing
+    //! the problem and the external library, which must then be reentrant. Other runners wait until it returns.
+    bp::dict    rollout_batch( bp::list initial_states, bp::list plans, double duration, double step );
+    //! rollout_threads - number of threads used by rollout_batch (0 to use all hardware threads)
+    unsigned    get_rollout_threads() { return _rollout_threads; }
+    void        set_rollout_threads( unsigned n ) { _rollout_threads = n; }
     //! load external symbols from path
     void        set_external_lib( std::string ex) { _external_dll_name = ex; }
     std::string get_external_lib() { return _external_dll_name; }
     void        load_external_symbols( ProblemInfo& );
+    void        open_external_library();
+    void        close_external_library();
 
     //! verify_plan - verifies the plan found (useful for debugging purposes)
     bool        get_verify_plan( ) { return _verify_plan; }
     void        set_verify_plan( bool flag) { _verify_plan = flag; }
 
+    //! plan_cache_size - maximum number of plans kept across calls to solve() (0 disables the cache)
+    unsigned    get_plan_cache_size() { return _plan_cache.capacity(); }
+    void        set_plan_cache_size( unsigned n ) { _plan_cache.set_capacity(n); }
+    //! plan_cache_tolerance - default quantisation step of float state variables for plan cache lookups
+    double      get_plan_cache_tolerance() { return _plan_cache.default_tolerance(); }
+    void        set_plan_cache_tolerance( double tol ) { _plan_cache.set_default_tolerance(tol); }
+    //! set_state_tolerance - quantisation step of a given state variable for plan cache lookups
+    void        set_state_tolerance( std::string var_name, double tol );
+    //! plan_cache_threshold - maximum loss of reward accepted when re-validating a cached plan
+    double      get_plan_cache_threshold() { return _plan_cache_threshold; }
+    void        set_plan_cache_threshold( double t ) { _plan_cache_threshold = t; }
+    //! plan cache statistics - read only
+    unsigned long get_plan_cache_hits() { return _plan_cache.hits(); }
+    unsigned long get_plan_cache_misses() { return _plan_cache.misses(); }
+    unsigned long get_plan_cache_rejections() { return _plan_cache.rejections(); }
+
+    //! incremental_replanning - reuse the remainder of the last plan when it is still valid
+    bool        get_incremental_replanning() { return _incremental_replanning; }
+    void        set_incremental_replanning( bool flag ) { _incremental_replanning = flag; }
+    //! replanning_min_steps - a valid remainder shorter than this is extended with a search from its last state
+    //! (0, the default, stands for half of the steps in the lookahead horizon)
+    unsigned    get_replanning_min_steps() { return _replanning_min_steps; }
+    void        set_replanning_min_steps( unsigned n ) { _replanning_min_steps = n; }
+    //! replanning_threshold - maximum loss of reward accepted when re-validating the remainder of the last plan
+    double      get_replanning_threshold() { return _replanning_threshold; }
+    void        set_replanning_threshold( double t ) { _replanning_threshold = t; }
+    //! clock_variable - the state variable holding the current time, used to align the last plan with the new state
+    std::string get_clock_variable() { return _clock_variable; }
+    void        set_clock_variable( std::string name ) { _clock_variable = name; }
+    //! lookahead integration step schedule, applied when the planner is set up (see DiscretizationSchedule)
+    //! schedule_fine_depth - depth up to which lookahead successors are integrated with delta_max (negative disables the schedule)
+    int         get_schedule_fine_depth() { return _schedule_fine_depth; }
+    void        set_schedule_fine_depth( int d ) { _schedule_fine_depth = d; set_user_option("lookahead.schedule.fine_depth", std::to_string(d)); }
+    //! schedule_growth - factor by which the integration step grows per level beyond schedule_fine_depth
+    double      get_schedule_growth() { return _schedule_growth; }
+    void        set_schedule_growth( double f ) { _schedule_growth = f; set_user_option("lookahead.schedule.growth", std::to_string(f)); }
+    //! schedule_max_step - upper bound on the integration step, required when the schedule is enabled
+    double      get_schedule_max_step() { return _schedule_max_step; }
+    void        set_schedule_max_step( double t ) { _schedule_max_step = t; set_user_option("lookahead.schedule.max_step", std::to_string(t)); }
+
+    //! incremental replanning statistics - read only
+    unsigned long get_num_plan_reuses() { return _num_plan_reuses; }
+    unsigned long get_num_plan_extensions() { return _num_plan_extensions; }
+    unsigned long get_num_full_searches() { return _num_full_searches; }
+
 protected:
 
     void        export_plan();
@@ -127,9 +195,16 @@ protected:
 
     void        index_state_variables();
 
+    bool        solve_from_plan_cache( const online::PlanCache::KeyT& key, online::PlanCache::PlanT& plan );
+    void        store_in_plan_cache( const online::PlanCache::KeyT& key, const online::PlanCache::PlanT& plan, const online::RolloutResult& outcome );
+    bool        solve_incrementally( online::PlanCache::PlanT& plan );
+    void        remember_plan( const online::PlanCache::PlanT& plan, const online::RolloutResult& outcome );
+
     void        report_stats(const Problem& problem, const std::string& out_dir);
     void        update(Config& cfg);
     bp::dict    decode_state( const State& s, const ProblemInfo& info );
+    std::shared_ptr<State> parse_state( bp::dict& state );
+    online::PlanRollout::ActionIdT action_id( const std::string& name );
 private:
 
 
@@ -138,6 +213,7 @@ private:
     EngineOptions                           _options;
     online::EngineRegistry                  _available_engines;
     double                                  _setup_time;
+    std::vector<std::pair<std::string, double>> _setup_stages;
     double                                  _search_time;
     double                                  _simulation_time;
     std::string                             _result;
@@ -160,8 +236,30 @@ private:
     std::shared_ptr<SimpleStateModel>       _state_model;
     std::string                             _external_dll_name;
     void*                                   _external_dll_handle;
+    ExternalBatchSignature                  _external_batch_function;
     ExternalCreatorFunction                 _external_creator;
     ExternalDestructorFunction              _external_destructor;
+    std::unique_ptr<ExternalBatchEvaluator> _external_batch;
+    online::PlanCache                       _plan_cache;
+    double                                  _plan_cache_threshold;
+    std::shared_ptr<online::PlanRollout>    _rollout;
+    bool                                    _incremental_replanning;
+    unsigned                                _replanning_min_steps;
+    double                                  _replanning_threshold;
+    std::string                             _clock_variable;
+    online::PlanCache::PlanT                _last_plan;
+    std::shared_ptr<State>                  _last_plan_state;
+    std::vector<float>                      _last_plan_rewards;
+    unsigned long                           _num_plan_reuses;
+    unsigned long                           _num_plan_extensions;
+    unsigned long                           _num_full_searches;
+    int                                     _schedule_fine_depth;
+    double                                  _schedule_growth;
+    double                                  _schedule_max_step;
+    unsigned                                _rollout_threads;
+    std::unique_ptr<ThreadPool>             _rollout_pool;
+    std::vector<std::shared_ptr<SimpleStateModel>> _rollout_models;
+    std::map< std::string, online::PlanRollout::ActionIdT > _action_index;
 };
 
 }} // namespace
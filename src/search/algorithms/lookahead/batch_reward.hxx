@@ -0,0 +1,33 @@
+
+#pragma once
+
+#include <vector>
+
+#include <fs/core/fs_types.hxx>
+
+namespace fs0 { namespace lookahead {
+
+//! A reward signal able to score a whole set of states with a single call, for those
+//! signals where the per-call overhead dominates the actual computation (e.g. rewards
+//! implemented by external libraries backed by physics engines). Lookahead engines that
+//! are given one use it to score all the successors of a node at once.
+class BatchReward {
+public:
+	virtual ~BatchReward() = default;
+
+	//! Sets rewards[i] to the (undiscounted) reward r(states[i])
+	virtual void evaluate(const std::vector<const State*>& states, std::vector<float>& rewards) = 0;
+
+	//! Convenience method for a batch of size one
+	float evaluate(const State& state) {
+		_single[0] = &state;
+		evaluate(_single, _single_reward);
+		return _single_reward[0];
+	}
+
+protected:
+	std::vector<const State*> _single = std::vector<const State*>(1, nullptr);
+	std::vector<float> _single_reward = std::vector<float>(1, 0.0f);
+};
+
+} } // namespaces
@@ -0,0 +1,196 @@
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef EDEBUG
+#include <set>
+#endif
+
+#include <lapkt/novelty/base.hxx>
+
+namespace fs0 { namespace lookahead {
+
+//! An open list which extracts nodes with fewer unachieved subgoals (#g) first, then nodes with
+//! lower g, then nodes with w_{#g} = 1, then nodes generated earlier. This is the intent of
+//! 'unachieved_subgoals_comparer', but since its w_{#g} test is one-sided, the heap sorted by that
+//! comparer may break ties within a same <#g, g> differently.
+//! Since #g and g are small integers, nodes are kept in FIFO buckets indexed by <#g, g>.
+//! Extraction takes amortized constant time, and so does insertion of nodes generated after all
+//! the nodes in their bucket. Other nodes (e.g. those pushed into the last queue of SBFWS) are
+//! inserted in sorted position, in time linear in the size of the bucket.
+template <typename NodeT, typename NodePT = std::shared_ptr<NodeT>>
+class UnachievedBucketOpenList {
+protected:
+	//! The nodes with the same <#g, g>, sorted by generation order. Extracted nodes are not erased
+	//! from the vector, we just move the 'head' forward until the bucket becomes empty.
+	struct Queue {
+		std::vector<NodePT> nodes;
+		std::size_t head = 0;
+
+		bool empty() const { return head == nodes.size(); }
+
+		void push(const NodePT& node) {
+			// Nodes are nearly always inserted by increasing generation order, but e.g. nodes
+			// pushed into the last queue of SBFWS are not
+			if (nodes.empty() || nodes.back()->_gen_order < node->_gen_order) {
+				nodes.push_back(node);
+				return;
+			}
+			auto it = std::upper_bound(nodes.begin() + head, nodes.end(), node,
+				[](const NodePT& n1, const NodePT& n2) { return n1->_gen_order < n2->_gen_order; });
+			nodes.insert(it, node);
+		}
+
+		NodePT pop() {
+			NodePT node = std::move(nodes[head++]);
+			if (empty()) clear();
+			return node;
+		}
+
+		void clear() { nodes.clear(); head = 0; }
+	};
+
+	struct Bucket {
+		//! Nodes with w_{#g} = 1
+		Queue novel;
+		//! The rest of nodes
+		Queue rest;
+
+		bool empty() const { return novel.empty() && rest.empty(); }
+	};
+
+#ifdef EDEBUG
+	//! The extraction order, as a strict weak order, to check the buckets against
+	struct ReferenceOrder {
+		bool operator()(const NodePT& n1, const NodePT& n2) const {
+			if (n1->unachieved_subgoals != n2->unachieved_subgoals) return n1->unachieved_subgoals < n2->unachieved_subgoals;
+			if (n1->g != n2->g) return n1->g < n2->g;
+			bool novel1 = n1->w_g == lapkt::novelty::Novelty::One, novel2 = n2->w_g == lapkt::novelty::Novelty::One;
+			if (novel1 != novel2) return novel1;
+			return n1->_gen_order < n2->_gen_order;
+		}
+	};
+#endif
+
+	struct NodeHasher { std::size_t operator()(const NodePT& node) const { return node->hash(); } };
+	struct NodeEquality { bool operator()(const NodePT& n1, const NodePT& n2) const { return *n1 == *n2; } };
+
+	//! _buckets[#g][g]
+	std::vector<std::vector<Bucket>> _buckets;
+
+	//! The <#g, g> of the first non-empty bucket, if any
+	unsigned _min_unachieved;
+	unsigned _min_g;
+
+	//! The buckets which have been used since the last time the list was cleared
+	std::vector<std::pair<unsigned, unsigned>> _used;
+
+	//! The number of nodes held in the buckets
+	std::size_t _size;
+
+	//! The states of the nodes currently in the list. Nodes with equal states are all kept in the
+	//! buckets, and share a single entry here which counts them
+	std::unordered_map<NodePT, unsigned, NodeHasher, NodeEquality> _index;
+
+#ifdef EDEBUG
+	//! All the nodes in the list, sorted by the extraction order
+	std::set<NodePT, ReferenceOrder> _reference;
+#endif
+
+public:
+	UnachievedBucketOpenList() : _size(0) { reset_cursor(); }
+
+	void insert(const NodePT& node) {
+		unsigned u = node->unachieved_subgoals, g = node->g;
+		if (u >= _buckets.size()) _buckets.resize(u + 1);
+		if (g >= _buckets[u].size()) _buckets[u].resize(g + 1);
+
+		Bucket& bucket = _buckets[u][g];
+		if (bucket.empty()) _used.push_back(std::make_pair(u, g));
+		if (node->w_g == lapkt::novelty::Novelty::One) bucket.novel.push(node);
+		else bucket.rest.push(node);
+		++_index[node];
+		++_size;
+#ifdef EDEBUG
+		_reference.insert(node);
+#endif
+
+		if (u < _min_unachieved || (u == _min_unachieved && g < _min_g)) {
+			_min_unachieved = u;
+			_min_g = g;
+		}
+	}
+
+	NodePT next() {
+		assert(!empty());
+		Bucket& bucket = _buckets[_min_unachieved][_min_g];
+		NodePT node = bucket.novel.empty() ? bucket.rest.pop() : bucket.novel.pop();
+		auto it = _index.find(node);
+		assert(it != _index.end() && it->second > 0);
+		if (--it->second == 0) _index.erase(it);
+		--_size;
+		if (bucket.empty()) advance_cursor();
+#ifdef EDEBUG
+		// The buckets must extract the same node as the set sorted by the extraction order
+		assert(!_reference.empty() && *_reference.begin() == node);
+		_reference.erase(_reference.begin());
+		assert(_reference.size() == _size);
+#endif
+		return node;
+	}
+
+	bool empty() const { return _size == 0; }
+
+	std::size_t size() const { return _size; }
+
+	bool contains(const NodePT& node) const { return _index.find(node) != _index.end(); }
+
+	//! Only the buckets used since the last clear need to be visited
+	void clear() {
+		for (const auto& ug:_used) {
+			Bucket& bucket = _buckets[ug.first][ug.second];
+			bucket.novel.clear();
+			bucket.rest.clear();
+		}
+		_used.clear();
+		_index.clear();
+		_size = 0;
+		reset_cursor();
+#ifdef EDEBUG
+		_reference.clear();
+#endif
+	}
+
+protected:
+	void reset_cursor() {
+		_min_unachieved = std::numeric_limits<unsigned>::max();
+		_min_g = std::numeric_limits<unsigned>::max();
+	}
+
+	//! Move the cursor to the next non-empty bucket, which necessarily comes after the current one
+	void advance_cursor() {
+		if (empty()) {
+			reset_cursor();
+			return;
+		}
+		for (unsigned u = _min_unachieved, g = _min_g + 1; u < _buckets.size(); ++u, g = 0) {
+			for (; g < _buckets[u].size(); ++g) {
+				if (!_buckets[u][g].empty()) {
+					_min_unachieved = u;
+					_min_g = g;
+					return;
+				}
+			}
+		}
+		assert(false); // Some bucket must be non-empty
+	}
+};
+
+} } // namespaces
@@ -0,0 +1,53 @@
+
+#include <search/algorithms/lookahead/discretization_schedule.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <fs/core/utils/config.hxx>
+
+namespace fs0 { namespace lookahead {
+
+DiscretizationSchedule::DiscretizationSchedule(const fs0::Config& config) :
+	_fine_depth(config.getOption<int>("lookahead.schedule.fine_depth", -1)),
+	_growth(config.getOption<float>("lookahead.schedule.growth", 2.0)),
+	_max_step(config.getOption<float>("lookahead.schedule.max_step", 0.0)),
+	_base(0.0),
+	_current(0.0)
+{
+	if ( enabled() && _growth < 1.0 )
+		throw std::runtime_error("[DiscretizationSchedule] : option 'lookahead.schedule.growth' must be at least 1");
+	// The lookaheads have no depth limit, so without a bound the step would grow without limit as well
+	if ( enabled() && _max_step <= 0.0 )
+		throw std::runtime_error("[DiscretizationSchedule] : option 'lookahead.schedule.max_step' must be positive when the schedule is enabled");
+}
+
+double
+DiscretizationSchedule::step(unsigned g, double base) const {
+	if ( !enabled() || g < static_cast<unsigned>(_fine_depth) ) return base;
+	double step = base * std::pow(_growth, g - _fine_depth + 1);
+	return std::max(base, std::min(step, _max_step));
+}
+
+void
+DiscretizationSchedule::apply(unsigned g) {
+	double delta = step(g, _base);
+	if ( delta == _current ) return;
+	fs0::Config::instance().setDiscretizationStep(delta);
+	_current = delta;
+}
+
+void
+DiscretizationSchedule::begin() {
+	_base = fs0::Config::instance().getDiscretizationStep();
+	_current = _base;
+}
+
+void
+DiscretizationSchedule::end() {
+	fs0::Config::instance().setDiscretizationStep(_base);
+	_current = _base;
+}
+
+} } // namespaces
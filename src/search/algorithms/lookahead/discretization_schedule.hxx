@@ -0,0 +1,61 @@
+
+#pragma once
+
+namespace fs0 { class Config; }
+
+namespace fs0 { namespace lookahead {
+
+//! A schedule for the integration step used to generate the successors of lookahead nodes
+//! as a function of their depth g. Nodes within the first 'fine_depth' levels are expanded with
+//! the base step (i.e. delta_max), and the step of deeper nodes grows geometrically by a factor
+//! 'growth' per level, up to 'max_step'. This trades accuracy on transitions far away from the
+//! root, which have little bearing on the action actually executed, for a longer horizon.
+//! The schedule is configured by the options 'lookahead.schedule.*', and disabled by default.
+class DiscretizationSchedule {
+public:
+	explicit DiscretizationSchedule(const fs0::Config& config);
+
+	bool enabled() const { return _fine_depth >= 0; }
+
+	//! The integration step for the successors of nodes at depth g, given the base step
+	double step(unsigned g, double base) const;
+
+	//! Sets the step of the global configuration to that for the successors of nodes at depth g.
+	//! Must be called between begin() and end().
+	void apply(unsigned g);
+
+	//! Records the base step of the global configuration at the beginning of a search
+	void begin();
+
+	//! Restores the base step of the global configuration
+	void end();
+
+	//! Applies the schedule for the lifetime of the object
+	class Scope {
+	public:
+		explicit Scope(DiscretizationSchedule& schedule) : _schedule(schedule) { if (_schedule.enabled()) _schedule.begin(); }
+		~Scope() { if (_schedule.enabled()) _schedule.end(); }
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	protected:
+		DiscretizationSchedule& _schedule;
+	};
+
+protected:
+	//! Depth up to which the base step is used, negative if the schedule is disabled
+	int _fine_depth;
+
+	//! Growth factor of the step per level beyond '_fine_depth'
+	double _growth;
+
+	//! Upper bound on the step, which must be positive if the schedule is enabled
+	double _max_step;
+
+	//! The base step recorded at the beginning of the current search
+	double _base;
+
+	//! The step currently set in the global configuration
+	double _current;
+};
+
+} } // namespaces
@@ -0,0 +1,14 @@
+#pragma once
+
+namespace fs0 { namespace lookahead {
+
+//! Computes the valuation of 'state' under the feature set 'features' into 'valuation'. Feature
+//! sets which can fill an existing valuation in place provide an overload of this function in
+//! their own namespace, found by argument-dependent lookup, so that the engines can reuse the
+//! same buffers for all the nodes they evaluate.
+template <typename FeatureSetT, typename StateT, typename ValuationT>
+void evaluate_features(const FeatureSetT& features, const StateT& state, ValuationT& valuation) {
+	valuation = features.evaluate(state);
+}
+
+} } // namespaces
@@ -0,0 +1,52 @@
+
+#include <search/algorithms/lookahead/fingerprint.hxx>
+
+#include <cmath>
+
+#include <fs/core/problem_info.hxx>
+#include <fs/core/state.hxx>
+
+namespace fs0 { namespace lookahead {
+
+//! The finalizer of the SplitMix64 generator, a cheap and well-distributed 64-bit mixer
+static inline uint64_t mix64(uint64_t z) {
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+StateFingerprinter::StateFingerprinter(const ProblemInfo& info, float tolerance) :
+	_is_float(info.getNumVariables()),
+	_tolerance(tolerance)
+{
+	for ( VariableIdx x = 0; x < info.getNumVariables(); x++ )
+		_is_float[x] = (info.sv_type(x) == type_id::float_t);
+}
+
+uint64_t
+StateFingerprinter::hash(VariableIdx x, const object_id& v) const {
+	int64_t q = ( _is_float[x] && _tolerance > 0.0f ) ?
+		static_cast<int64_t>(std::floor(fs0::value<float>(v) / _tolerance)) :
+		static_cast<int64_t>(v.value());
+	return mix64(mix64(x + 0x9e3779b97f4a7c15ULL) ^ static_cast<uint64_t>(q));
+}
+
+uint64_t
+StateFingerprinter::compute(const State& s) const {
+	uint64_t fingerprint = 0;
+	for ( VariableIdx x = 0; x < _is_float.size(); x++ )
+		fingerprint ^= hash(x, s.getValue(x));
+	return fingerprint;
+}
+
+uint64_t
+StateFingerprinter::update(uint64_t fingerprint, const State& parent, const State& s) const {
+	for ( VariableIdx x = 0; x < _is_float.size(); x++ ) {
+		object_id v = s.getValue(x), w = parent.getValue(x);
+		if ( v == w ) continue;
+		fingerprint ^= hash(x, w) ^ hash(x, v);
+	}
+	return fingerprint;
+}
+
+} } // namespaces
@@ -0,0 +1,39 @@
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <fs/core/fs_types.hxx>
+
+namespace fs0 { class ProblemInfo; class State; }
+
+namespace fs0 { namespace lookahead {
+
+//! Computes compact 64-bit fingerprints of states, as the XOR of the hashes of all pairs <x, v>,
+//! where v is the value of state variable x, quantised to a given tolerance for float variables.
+//! Since every variable contributes independently to the fingerprint, the fingerprint of a
+//! successor can be obtained from that of its parent by rehashing only the variables that changed.
+class StateFingerprinter {
+public:
+	//! A tolerance of 0 fingerprints the exact values of float variables
+	StateFingerprinter(const ProblemInfo& info, float tolerance);
+
+	//! The fingerprint of the given state
+	uint64_t compute(const State& s) const;
+
+	//! The fingerprint of 's', given the fingerprint of some other state 'parent'
+	uint64_t update(uint64_t fingerprint, const State& parent, const State& s) const;
+
+	float tolerance() const { return _tolerance; }
+
+protected:
+	//! Whether each of the state variables is a float variable
+	std::vector<bool> _is_float;
+
+	float _tolerance;
+
+	uint64_t hash(VariableIdx x, const object_id& v) const;
+};
+
+} } // namespaces
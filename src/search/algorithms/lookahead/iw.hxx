@@ -2,6 +2,9 @@
 #pragma once
 
 #include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
 #include <unordered_set>
 
 
@@ -20,6 +23,13 @@
 #include <lapkt/tools/logging.hxx>
 #include <fs/core/heuristics/novelty/features.hxx>
 #include <fs/core/heuristics/reward.hxx>
+#include <search/algorithms/lookahead/batch_reward.hxx>
+#include <search/algorithms/lookahead/discretization_schedule.hxx>
+#include <search/algorithms/lookahead/feature_valuation.hxx>
+#include <search/algorithms/lookahead/transition_cache.hxx>
+#include <search/algorithms/lookahead/fingerprint.hxx>
+#include <search/algorithms/lookahead/reward_bound.hxx>
+#include <search/algorithms/lookahead/subgoal_index.hxx>
 
 // For logging search trees
 #include <search/algorithms/lookahead/treelog.hxx>
@@ -60,6 +70,9 @@ public:
 	//! NOTE We're assuming we won't generate more than 2^32 ~ 4.2 billion nodes.
 	uint32_t _gen_order;
 
+	//! The fingerprint of the state, only computed when duplicate pruning is enabled
+	uint64_t _fingerprint;
+
 
 	IWNode() = default;
 	~IWNode() = default;
@@ -79,7 +92,8 @@ public:
 		g(parent ? parent->g+1 : 0),
 		_w(std::numeric_limits<unsigned char>::max()),
         R(0.0f),
-		_gen_order(gen_order)
+		_gen_order(gen_order),
+		_fingerprint(0)
 	{
 		assert(_gen_order > 0); // Very silly way to detect overflow, in case we ever generate > 4 billion nodes :-)
 	}
@@ -91,7 +105,8 @@ public:
 		g(parent ? parent->g+1 : 0),
 		_w(std::numeric_limits<unsigned char>::max()),
         R(0.0f),
-		_gen_order(gen_order)
+		_gen_order(gen_order),
+		_fingerprint(0)
 	{
 		assert(_gen_order > 0); // Very silly way to detect overflow, in case we ever generate > 4 billion nodes :-)
 	}
@@ -129,24 +144,42 @@ protected:
 	//! A single novelty evaluator will be in charge of evaluating all nodes
 	std::unique_ptr<NoveltyEvaluatorT> _evaluator;
 
+	//! Whether the evaluator must be reset before it is used again. Resetting is deferred, so that
+	//! consecutive resets (e.g. at the end of a run and at the beginning of the next search) clear the tables once
+	bool _stale;
+
 public:
 
     typedef typename NoveltyEvaluatorT::ValuationT ValuationT;
 
+protected:
+	//! The valuations of the node being evaluated and of its parent, reused across evaluations
+	ValuationT _valuation;
+	ValuationT _parent_valuation;
+
+public:
 	LazyEvaluator(const FeatureSetT& features, NoveltyEvaluatorT* evaluator) :
 		_features(features),
-		_evaluator(evaluator)
+		_evaluator(evaluator),
+		_stale(false)
 	{}
 
 	~LazyEvaluator() = default;
 
 	//! Returns false iff we want to prune this node during the search
 	unsigned evaluate(NodeT& node) {
+		if (_stale) {
+			_evaluator->reset();
+			_stale = false;
+		}
 		if (node.parent) {
 			// Important: the novel-based computation works only when the parent has the same novelty type and thus goes against the same novelty tables!!!
-			node._w = _evaluator->evaluate(_features.evaluate(node.state), _features.evaluate(node.parent->state));
+			evaluate_features(_features, node.state, _valuation);
+			evaluate_features(_features, node.parent->state, _parent_valuation);
+			node._w = _evaluator->evaluate(_valuation, _parent_valuation);
 		} else {
-			node._w = _evaluator->evaluate(_features.evaluate(node.state));
+			evaluate_features(_features, node.state, _valuation);
+			node._w = _evaluator->evaluate(_valuation);
 		}
 
 		return node._w;
@@ -154,12 +187,12 @@ public:
 
 	std::vector<Width1Tuple> reached_tuples() const {
 		std::vector<Width1Tuple> tuples;
-		_evaluator->mark_tuples_in_novelty1_table(tuples);
+		if (!_stale) _evaluator->mark_tuples_in_novelty1_table(tuples);
 		return tuples;
 	}
 
 	void reset() {
-		_evaluator->reset();
+		_stale = true;
 	}
 
     const FeatureSetT& feature_set() const { return _features; }
@@ -197,6 +230,8 @@ public:
 
 	using RewardPT = std::shared_ptr<Reward>;
 
+	using BatchRewardPT = std::shared_ptr<BatchReward>;
+
 
 	// MRJ: IW(1) debugging
 	std::vector<NodePT>	_visited;
@@ -235,6 +270,15 @@ public:
 		//! discount factor
 		float 	_discount_factor;
 
+		//! Re-check only the subgoals that mention some variable changed by the last transition
+		bool	_incremental_goals;
+
+		//! Prune successors whose state fingerprint has already been seen in the current run
+		bool	_duplicate_pruning;
+
+		//! The tolerance to which float variables are quantised in state fingerprints
+		float	_duplicate_tolerance;
+
 		Config(bool complete, unsigned max_width, const fs0::Config& global_config) :
 			_complete(complete),
 			_max_width(max_width),
@@ -246,7 +290,10 @@ public:
 			_log_search(global_config.getOption<bool>("lookahead.iw.log", false)),
 			_num_brfs_layers(global_config.getOption<int>("lookahead.iw.layers", 0)),
 			_pivot_on_rewards(global_config.getOption<bool>("lookahead.iw.pivot_on_rewards", false)),
-			_discount_factor(global_config.getOption<float>("lookahead.iw.discount_factor", 1.0))
+			_discount_factor(global_config.getOption<float>("lookahead.iw.discount_factor", 1.0)),
+			_incremental_goals(global_config.getOption<bool>("lookahead.iw.incremental_goals", false)),
+			_duplicate_pruning(global_config.getOption<bool>("lookahead.iw.duplicate_pruning", false)),
+			_duplicate_tolerance(global_config.getOption<float>("lookahead.iw.duplicate_tolerance", 0.0))
 		{
 		}
 	};
@@ -261,11 +308,44 @@ protected:
     //! Best node found
 	NodePT _best_node;
 
-	//!
+	//! '_optimal_paths[i]' is the first node found in the current run that reaches the i-th goal atom,
+	//! if '_optimal_paths_epoch[i]' is the current run, and is stale otherwise
 	std::vector<NodePT> _optimal_paths;
+	std::vector<unsigned long> _optimal_paths_epoch;
+
+	//! The current run, bumped to forget the optimal paths of the previous runs
+	unsigned long _epoch;
+
+	//! '_unreached[i]' is true iff the i-th goal atom has not yet been reached.
+	std::vector<bool> _unreached;
+
+	//! The number of goal atoms that have not yet been reached.
+	unsigned _num_unreached;
+
+	//! The index of subgoals by the state variables they mention, if incremental goal checking is enabled
+	std::unique_ptr<SubgoalIndex> _subgoal_index;
+
+	//! Buffer for the subgoals to be checked on a node
+	std::vector<unsigned> _touched;
+
+	//! The integration step schedule
+	DiscretizationSchedule _schedule;
+
+	//! Transitions memoized across searches, if any
+	std::shared_ptr<TransitionCache> _transitions;
+
+	//! Raised by some other thread when the search must stop and return the best plan found so far
+	const std::atomic<bool>* _cancelled;
+
+	//! The state fingerprinter, if duplicate pruning is enabled
+	std::unique_ptr<StateFingerprinter> _fingerprinter;
+
+	//! The nodes generated in the current run, by state fingerprint. With exact fingerprints, nodes are only
+	//! duplicates if their states are equal, so all the nodes with colliding fingerprints are kept
+	std::unordered_map<uint64_t, std::vector<NodePT>> _seen;
 
-	//! '_unreached' contains the indexes of all those goal atoms that have yet not been reached.
-	std::unordered_set<unsigned> _unreached;
+	//! The bound on the reward of the descendants of a node, if reward-bound pruning is enabled
+	std::unique_ptr<RewardBound> _bound;
 
 	//! Contains the indexes of all those goal atoms that were already reached in the seed state
 	std::vector<bool> _in_seed;
@@ -279,10 +359,21 @@ protected:
 	//! Whether to print some useful extra information or not
 	bool _verbose;
 
+	//! Whether to stay silent during the search, e.g. when other engines search concurrently
+	bool _quiet;
+
 
 	// MRJ: Reward Function
 	RewardPT	_reward_function;
 
+	//! Batched reward function, used instead of _reward_function to compute r(s) when set
+	BatchRewardPT	_batch_reward;
+
+	//! Buffers for the batched evaluation of the successors of a node
+	std::vector<NodePT> _successors;
+	std::vector<const StateT*> _batch_states;
+	std::vector<float> _batch_rewards;
+
 public:
 
 	//! Constructor
@@ -291,12 +382,25 @@ public:
 		_config(config),
         _best_node(nullptr),
 		_optimal_paths(model.num_subgoals()),
+		_optimal_paths_epoch(model.num_subgoals(), 0),
+		_epoch(1),
 		_unreached(),
+		_num_unreached(0),
+		_subgoal_index(config._incremental_goals ? SubgoalIndex::create(model.getTask(), model.num_subgoals()) : nullptr),
+		_touched(),
+		_schedule(config._global_config),
+		_transitions(nullptr),
+		_cancelled(nullptr),
+		_fingerprinter(config._duplicate_pruning ? new StateFingerprinter(ProblemInfo::getInstance(), config._duplicate_tolerance) : nullptr),
+		_seen(),
+		_bound(RewardBound::create(config._global_config, config._discount_factor)),
 		_in_seed(),
 		_evaluator(featureset, evaluator),
 		_stats(stats),
 		_verbose(verbose),
-		_reward_function(nullptr)
+		_quiet(false),
+		_reward_function(nullptr),
+		_batch_reward(nullptr)
 	{
 	}
 
@@ -304,14 +408,29 @@ public:
 		return _best_node;
 	}
 
+	//! Also drops the nodes kept from the last search, which would otherwise keep its whole tree alive
+	//! until the next search overwrites them
 	void reset() {
-		std::vector<NodePT> _(_optimal_paths.size(), nullptr);
-		_optimal_paths.swap(_);
+		start_new_run();
+		std::fill(_optimal_paths.begin(), _optimal_paths.end(), nullptr);
+		_seen.clear();
         _best_node = nullptr;
-		_evaluator.reset();
 		_stats.reset();
 	}
 
+	//! Forget the optimal paths of the previous run by bumping the epoch. The novelty tables have no
+	//! epoch of their own, so the evaluator still clears them in full before its next use, i.e. once
+	//! per run, and thus once per root action of the BrFS layer.
+	void start_new_run() {
+		++_epoch;
+		_evaluator.reset();
+	}
+
+	//! The first node of the current run that reached the given goal atom, if any
+	NodePT optimal_path(unsigned subgoal_idx) const {
+		return (_optimal_paths_epoch[subgoal_idx] == _epoch) ? _optimal_paths[subgoal_idx] : nullptr;
+	}
+
 	~IW() = default;
 
 	// Disallow copy, but allow move
@@ -325,7 +444,7 @@ public:
 	std::vector<NodePT> extract_seed_nodes() {
 		std::vector<NodePT> seed_nodes;
 		for (unsigned subgoal_idx = 0; subgoal_idx < _optimal_paths.size(); ++subgoal_idx) {
-			if (!_in_seed[subgoal_idx] && _optimal_paths[subgoal_idx] != nullptr) {
+			if (!_in_seed[subgoal_idx] && optimal_path(subgoal_idx) != nullptr) {
 				seed_nodes.push_back(_optimal_paths[subgoal_idx]);
 			}
 		}
@@ -355,16 +474,57 @@ public:
 		return _reward_function;
 	}
 
+	//!
+	void set_batch_reward( BatchRewardPT f ) {
+		_batch_reward = f;
+	}
+
+	//! Memoize the transitions of the search in the given cache
+	void set_transition_cache( std::shared_ptr<TransitionCache> cache ) {
+		_transitions = cache;
+	}
+
+	//! Stop the search as soon as the given flag is raised
+	void set_cancellation_flag( const std::atomic<bool>* flag ) {
+		_cancelled = flag;
+	}
+
+	//! Do not log anything during the search
+	void set_quiet( bool quiet ) {
+		_quiet = quiet;
+	}
+
+	bool cancelled() const {
+		return _cancelled != nullptr && _cancelled->load(std::memory_order_relaxed);
+	}
+
 	//! Evaluate reward
 	void evaluate_reward( NodePT n ) const {
+		if ( _batch_reward != nullptr ) {
+			accumulate_reward(n, _batch_reward->evaluate(n->state));
+			return;
+		}
 		if ( _reward_function == nullptr ) {
 			n->R = 0.0f;
 			return;
 		}
-		n->R = std::pow(_config._discount_factor,n->g)*_reward_function->evaluate(n->state);
+		accumulate_reward(n, _reward_function->evaluate(n->state));
+	}
+
+	//! Evaluate the reward of all the given nodes with a single call to the batched reward function
+	void evaluate_reward_batch( const std::vector<NodePT>& nodes ) {
+		_batch_states.clear();
+		for ( const auto& n : nodes ) _batch_states.push_back(&(n->state));
+		_batch_reward->evaluate(_batch_states, _batch_rewards);
+		for ( unsigned i = 0; i < nodes.size(); i++ )
+			accumulate_reward(nodes[i], _batch_rewards[i]);
+	}
+
+	//! Discount r(s) and accumulate it along the path to the node
+	void accumulate_reward( NodePT n, float r ) const {
+		n->R = std::pow(_config._discount_factor,n->g)*r;
 		if ( n->parent != nullptr )
 			n->R += n->parent->R; // accumulate
-		return;
 	}
 
     //! Convenience method
@@ -372,61 +532,58 @@ public:
 
 	bool search(const StateT& s, PlanT& plan) {
         _best_node = nullptr; // Make sure we start assuming no solution found
+		DiscretizationSchedule::Scope schedule_scope(_schedule);
 		NodePT top_level = std::make_shared<NodeT>(s, _stats.generated());
 
 		if ( _config._pivot_on_rewards ) {
-			LPT_INFO("search", "Pivoting on rewards...");
+			if (!_quiet) LPT_INFO("search", "Pivoting on rewards...");
 			NodePT current_best = _best_node;
 			if ( _config._num_brfs_layers > 0 ) {
-				LPT_INFO("search", "Using the lookahead...");
+				if (!_quiet) LPT_INFO("search", "Using the lookahead...");
 				unsigned num_app_root = 0;
 				for (const auto& a : _model.applicable_actions(s, _config._enforce_state_constraints)) {
-					StateT s_a = _model.next( s, a );
+					if (cancelled()) break;
+					StateT s_a = successor( s, a, 0 );
 					_stats.generation();
 
 		        	run(s_a, _config._max_width, top_level, a);
-					LPT_INFO("search", "Finished run " << ++num_app_root << ": max R(s)=" << _best_node->R << " visited: " << _visited.size() );
-					std::vector<NodePT> _(_optimal_paths.size(), nullptr);
-					_optimal_paths.swap(_);
-					_evaluator.reset();
-					LPT_INFO("search", "Run finished for action: #" << num_app_root);
+					++num_app_root;
+					if (!_quiet) LPT_INFO("search", "Finished run " << num_app_root << ": max R(s)=" << _best_node->R << " visited: " << _visited.size() );
+					start_new_run();
+					if (!_quiet) LPT_INFO("search", "Run finished for action: #" << num_app_root);
 				}
-				LPT_INFO("search", "Number of applicable actions: " << num_app_root);
+				if (!_quiet) LPT_INFO("search", "Number of applicable actions: " << num_app_root);
 			}
 			else {
 				run(s, _config._max_width, nullptr, (ActionIdT)0);
-				LPT_INFO("search", "Finished first run: max R(s)=" << _best_node->R << " visited: " << _visited.size() );
+				if (!_quiet) LPT_INFO("search", "Finished first run: max R(s)=" << _best_node->R << " visited: " << _visited.size() );
 			}
-			std::vector<NodePT> _(_optimal_paths.size(), nullptr);
-			_optimal_paths.swap(_);
-			_evaluator.reset();
-			while ( _best_node != current_best ){
+			start_new_run();
+			while ( _best_node != current_best && !cancelled() ){
 				current_best = _best_node;
 				for (const auto& a : _model.applicable_actions(current_best->state, _config._enforce_state_constraints)) {
-					StateT s_a = _model.next( current_best->state, a );
+					if (cancelled()) break;
+					StateT s_a = successor( current_best->state, a, current_best->g );
 					_stats.generation();
 
 					run(s_a, _config._max_width, current_best, a);
-					LPT_INFO("search", "Finished run: max R(s)=" << _best_node->R << " visited: " << _visited.size() );
-					std::vector<NodePT> _(_optimal_paths.size(), nullptr);
-					_optimal_paths.swap(_);
-					_evaluator.reset();
+					if (!_quiet) LPT_INFO("search", "Finished run: max R(s)=" << _best_node->R << " visited: " << _visited.size() );
+					start_new_run();
 				}
 			}
 			return extract_plan( _best_node, plan );
 		}
 
 		if ( _config._num_brfs_layers > 0 ) {
-			LPT_INFO("search", "Using the lookahead...");
+			if (!_quiet) LPT_INFO("search", "Using the lookahead...");
 			for (const auto& a : _model.applicable_actions(s, _config._enforce_state_constraints)) {
-				StateT s_a = _model.next( s, a );
+				if (cancelled()) break;
+				StateT s_a = successor( s, a, 0 );
 				_stats.generation();
 
 	        	run(s_a, _config._max_width, top_level, a);
-				LPT_INFO("search", "Finished run: max R(s)=" << _best_node->R << " visited: " << _visited.size() );
-				std::vector<NodePT> _(_optimal_paths.size(), nullptr);
-				_optimal_paths.swap(_);
-				_evaluator.reset();
+				if (!_quiet) LPT_INFO("search", "Finished run: max R(s)=" << _best_node->R << " visited: " << _visited.size() );
+				start_new_run();
 			}
 		}
 		else
@@ -451,11 +608,11 @@ public:
     }
 
 	bool run(const StateT& seed, unsigned max_width, NodePT top_level, ActionIdT a ) {
-		if (_verbose) LPT_INFO("search", "Simulation - Starting IW Simulation");
+		if (_verbose && !_quiet) LPT_INFO("search", "Simulation - Starting IW Simulation");
 
 		std::shared_ptr<DeactivateZCC> zcc_setting = nullptr;
 		if (!_config._enforce_state_constraints ) {
-			LPT_INFO("search", ":Simulation - Deactivating zero crossing control");
+			if (!_quiet) LPT_INFO("search", ":Simulation - Deactivating zero crossing control");
 			zcc_setting = std::make_shared<DeactivateZCC>();
 		}
 
@@ -467,6 +624,11 @@ public:
 
 		_stats.generation();
 		mark_seed_subgoals(root);
+		if (_fingerprinter) {
+			_seen.clear();
+			root->_fingerprint = _fingerprinter->compute(root->state);
+			_seen[root->_fingerprint].push_back(root);
+		}
 
 		auto nov =_evaluator.evaluate(*root);
 		assert(nov==1);
@@ -495,31 +657,46 @@ public:
 
 		while (true) {
 			while (!open_w1.empty() || !open_w2.empty()) {
+				if (cancelled()) {
+					report("Cancelled");
+					return false;
+				}
 				NodePT current = open_w1.empty() ? open_w2.next() : open_w1.next();
+				if (!can_improve(current)) continue;
 
 				// Expand the node
 				update_novelty_counters_on_expansion(current->_w);
 				_stats.expansion();
+				if ( _batch_reward != nullptr ) {
+					// Generate all successors first, so that they can be scored with a single call
+					_successors.clear();
+					for (const auto& a : _model.applicable_actions(current->state, _config._enforce_state_constraints)) {
+						StateT s_a = successor( current->state, a, current->g );
+						NodePT successor = std::make_shared<NodeT>(std::move(s_a), a, current, _stats.generated());
+						_stats.generation();
+						if (is_duplicate(successor)) continue;
+						_successors.push_back(successor);
+					}
+					evaluate_reward_batch(_successors);
+					for (const auto& successor : _successors) {
+						if (handle_successor(successor, max_width, open_w1_next, open_w2_next)) {
+							report("All subgoals reached");
+							return true;
+						}
+					}
+					continue;
+				}
+
 				for (const auto& a : _model.applicable_actions(current->state, _config._enforce_state_constraints)) {
-					StateT s_a = _model.next( current->state, a );
+					StateT s_a = successor( current->state, a, current->g );
 					NodePT successor = std::make_shared<NodeT>(std::move(s_a), a, current, _stats.generated());
 					_stats.generation();
+					if (is_duplicate(successor)) continue;
 					evaluate_reward(successor);
-					update_best_node(successor);
-					unsigned char novelty = _evaluator.evaluate(*successor);
-					update_novelty_counters_on_generation(novelty);
-
-					// LPT_INFO("search", "Simulation - Node generated: " << *successor);
-					if (_config._log_search )
-						_visited.push_back(successor);
-
-					if (process_node(successor)) {  // i.e. all subgoals have been reached before reaching the bound
+					if (handle_successor(successor, max_width, open_w1_next, open_w2_next)) {  // i.e. all subgoals have been reached before reaching the bound
 						report("All subgoals reached");
 						return true;
 					}
-
-					if (novelty <= max_width && novelty == 1) open_w1_next.insert(successor);
-					else if (novelty <= max_width && novelty == 2) open_w2_next.insert(successor);
 				}
 
 			}
@@ -544,9 +721,9 @@ public:
 	}
 
 	void report(const std::string& result) const {
-		if (!_verbose) return;
+		if (!_verbose || _quiet) return;
 		LPT_INFO("search", "Simulation - Result: " << result);
-		LPT_INFO("search", "Simulation - Num reached subgoals: " << (_model.num_subgoals() - _unreached.size()) << " / " << _model.num_subgoals());
+		LPT_INFO("search", "Simulation - Num reached subgoals: " << (_model.num_subgoals() - _num_unreached) << " / " << _model.num_subgoals());
 		LPT_INFO("search", "Simulation - Generated nodes with w=1 " << _stats.num_w1_nodes());
 		LPT_INFO("search", "Simulation - Generated nodes with w=2 " << _stats.num_w2_nodes());
 		LPT_INFO("search", "Simulation - Generated nodes with w>2 " << _stats.num_wgt2_nodes());
@@ -557,6 +734,61 @@ public:
 
 protected:
 
+	//! The successor of a state at depth g, integrated with the step given by the schedule
+	StateT successor(const StateT& s, const ActionIdT& a, unsigned g) {
+		if (_schedule.enabled()) _schedule.apply(g);
+		if (_transitions) return _transitions->next(_model, s, a);
+		return _model.next(s, a);
+	}
+
+	//! Returns false iff reward-bound pruning is enabled and no descendant of the node could replace the best
+	//! node so far. As update_best_node() prefers deeper nodes regardless of their reward, this requires that
+	//! no descendant within the depth considered by the bound is deeper than the best node, nor has a greater reward.
+	bool can_improve(const NodePT& node) {
+		if (!_bound || _best_node == nullptr) return true;
+		if (_best_node->g < _bound->max_depth()) return true;
+		if (_bound->can_improve(node->R, node->g, _best_node->R)) return true;
+		_stats.bound_pruned();
+		return false;
+	}
+
+	//! Returns true iff duplicate pruning is enabled and the state of the given node has already been
+	//! generated in the current run, i.e. exactly the same state or, if float variables are quantised,
+	//! a state with the same fingerprint
+	bool is_duplicate(const NodePT& node) {
+		if (!_fingerprinter) return false;
+		node->_fingerprint = _fingerprinter->update(node->parent->_fingerprint, node->parent->state, node->state);
+		std::vector<NodePT>& seen = _seen[node->_fingerprint];
+		bool exact = _fingerprinter->tolerance() <= 0.0f;
+		bool duplicate = exact ?
+			std::any_of(seen.begin(), seen.end(), [&node](const NodePT& other) { return other->state == node->state; }) :
+			!seen.empty();
+		if (!duplicate) {
+			seen.push_back(node);
+			return false;
+		}
+		_stats.duplicate();
+		return true;
+	}
+
+	//! Computes the novelty of a (scored) successor node and puts it in the open list that corresponds.
+	//! Returns true iff all goal atoms have been reached in the IW search
+	bool handle_successor(NodePT successor, unsigned max_width, OpenListT& open_w1_next, OpenListT& open_w2_next) {
+		update_best_node(successor);
+		unsigned char novelty = _evaluator.evaluate(*successor);
+		update_novelty_counters_on_generation(novelty);
+
+		// LPT_INFO("search", "Simulation - Node generated: " << *successor);
+		if (_config._log_search )
+			_visited.push_back(successor);
+
+		if (process_node(successor)) return true;
+
+		if (novelty <= max_width && novelty == 1) open_w1_next.insert(successor);
+		else if (novelty <= max_width && novelty == 2) open_w2_next.insert(successor);
+		return false;
+	}
+
 	//! Returns true iff all goal atoms have been reached in the IW search
 	bool process_node(NodePT& node) {
 		if (_config._complete) return process_node_complete(node);
@@ -565,41 +797,53 @@ protected:
 
 		// We iterate through the indexes of all those goal atoms that have not yet been reached in the IW search
 		// to check if the current node satisfies any of them - and if it does, we mark it appropriately.
-		for (auto it = _unreached.begin(); it != _unreached.end(); ) {
-			unsigned subgoal_idx = *it;
-
-			if (_model.goal(state, subgoal_idx)) {
-                // MRJ: Reward function
-				_stats.generation_g_decrease();
-// 				node->satisfies_subgoal = true;
-// 				_all_paths[subgoal_idx].push_back(node);
-				if (!_optimal_paths[subgoal_idx]) _optimal_paths[subgoal_idx] = node;
-				it = _unreached.erase(it);
-			} else {
-				++it;
+		// Since no unreached goal atom holds in the parent, only those affected by the transition can hold now.
+		if (_subgoal_index) {
+			_subgoal_index->touched(state, node->parent->state, _touched);
+			for (unsigned subgoal_idx:_touched) {
+				if (_unreached[subgoal_idx] && _model.goal(state, subgoal_idx)) mark_reached(node, subgoal_idx);
+			}
+		} else {
+			for (unsigned subgoal_idx = 0; subgoal_idx < _unreached.size(); ++subgoal_idx) {
+				if (_unreached[subgoal_idx] && _model.goal(state, subgoal_idx)) mark_reached(node, subgoal_idx);
 			}
 		}
 
 		// As soon as all nodes have been processed, we return true so that we can stop the search
-		return _unreached.empty();
+		return _num_unreached == 0;
 	}
 
 	//! Returns true iff all goal atoms have been reached in the IW search
+	//! With incremental goal checking, goal atoms already true in the parent are not counted again
 	bool process_node_complete(NodePT& node) {
 		const StateT& state = node->state;
 
-		for (unsigned i = 0; i < _model.num_subgoals(); ++i) {
-			if (!_in_seed[i] && _model.goal(state, i)) {
-// 				node->satisfies_subgoal = true;
-				_stats.generation_g_decrease();
-				if (!_optimal_paths[i]) _optimal_paths[i] = node;
-				_unreached.erase(i);
+		if (_subgoal_index) {
+			_subgoal_index->touched(state, node->parent->state, _touched);
+			for (unsigned i:_touched) {
+				if (!_in_seed[i] && _model.goal(state, i)) mark_reached(node, i);
+			}
+		} else {
+			for (unsigned i = 0; i < _model.num_subgoals(); ++i) {
+				if (!_in_seed[i] && _model.goal(state, i)) mark_reached(node, i);
 			}
 		}
- 		return _unreached.empty();
+ 		return _num_unreached == 0;
 		//return false; // return false so we don't interrupt the processing
 	}
 
+	void mark_reached(const NodePT& node, unsigned subgoal_idx) {
+		_stats.generation_g_decrease();
+		if (_optimal_paths_epoch[subgoal_idx] != _epoch) {
+			_optimal_paths[subgoal_idx] = node;
+			_optimal_paths_epoch[subgoal_idx] = _epoch;
+		}
+		if (_unreached[subgoal_idx]) {
+			_unreached[subgoal_idx] = false;
+			--_num_unreached;
+		}
+	}
+
     void update_best_node( const NodePT& node ) {
 
         if ( _best_node->g < node->g || node->R > _best_node->R ) {
@@ -610,14 +854,16 @@ protected:
     }
 
 	void mark_seed_subgoals(const NodePT& node) {
-		std::vector<bool> _(_model.num_subgoals(), false);
-		_in_seed.swap(_);
-		_unreached.clear();
+		// Reuse the buffers of the previous run
+		_in_seed.assign(_model.num_subgoals(), false);
+		_unreached.assign(_model.num_subgoals(), false);
+		_num_unreached = 0;
 		for (unsigned i = 0; i < _model.num_subgoals(); ++i) {
 			if (_model.goal(node->state, i)) {
 				_in_seed[i] = true;
 			} else {
-				_unreached.insert(i);
+				_unreached[i] = true;
+				++_num_unreached;
 			}
 		}
 	}
@@ -31,6 +31,8 @@ namespace fs0 { namespace lookahead {
 
     		std::make_tuple("_num_expanded_g_decrease", "Expansions with #g decrease", std::to_string(_num_expanded_g_decrease)),
     		std::make_tuple("_num_generated_g_decrease", "Generations with #g decrease", std::to_string(_num_generated_g_decrease)),
+    		std::make_tuple("_num_duplicates", "Generations pruned as duplicates", std::to_string(_num_duplicates)),
+    		std::make_tuple("_num_bound_pruned", "Expansions pruned by the reward bound", std::to_string(_num_bound_pruned)),
             std::make_tuple("_initial_reward", "r(s0)", std::to_string(_initial_reward)),
             std::make_tuple("_max_reward", "max r(s)", std::to_string(_max_reward)),
             std::make_tuple("_max_depth", "max g(s)", std::to_string(_max_depth))
@@ -22,6 +22,12 @@ namespace fs0 { namespace lookahead {
     	void expansion_g_decrease() { ++_num_expanded_g_decrease; }
     	void generation_g_decrease() { ++_num_generated_g_decrease; }
 
+    	void duplicate() { ++_num_duplicates; }
+    	unsigned long num_duplicates() const { return _num_duplicates; }
+
+    	void bound_pruned() { ++_num_bound_pruned; }
+    	unsigned long num_bound_pruned() const { return _num_bound_pruned; }
+
     	unsigned long num_w1_nodes() const { return _num_w1_nodes; }
     	unsigned long num_w2_nodes() const { return _num_w2_nodes; }
     	unsigned long num_wgt2_nodes() const { return _num_wgt2_nodes; }
@@ -53,6 +59,8 @@ namespace fs0 { namespace lookahead {
             _num_wgt2_nodes = 0; // The number of nodes with w_{F} > 2 that have been processed.
         	_num_expanded_g_decrease = 0; // The number of nodes with a decrease in #g that are expanded
         	_num_generated_g_decrease = 0; // The number of nodes with a decrease in #g that are expanded
+        	_num_duplicates = 0; // The number of generated nodes pruned as duplicates
+        	_num_bound_pruned = 0; // The number of nodes not expanded because they could not improve the best reward
 
             _initial_reward = 0.0f;
             _max_reward = -std::numeric_limits<float>::max();
@@ -75,6 +83,8 @@ namespace fs0 { namespace lookahead {
         unsigned long _num_wgt2_nodes = 0; // The number of nodes with w_{F} > 2 that have been processed.
     	unsigned long _num_expanded_g_decrease = 0; // The number of nodes with a decrease in #g that are expanded
     	unsigned long _num_generated_g_decrease = 0; // The number of nodes with a decrease in #g that are expanded
+    	unsigned long _num_duplicates = 0; // The number of generated nodes pruned as duplicates
+    	unsigned long _num_bound_pruned = 0; // The number of nodes not expanded because they could not improve the best reward
 
         float   _initial_reward = 0.0f;
         float   _max_reward = -std::numeric_limits<float>::max();
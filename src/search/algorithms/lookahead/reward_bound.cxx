@@ -0,0 +1,53 @@
+
+#include <search/algorithms/lookahead/reward_bound.hxx>
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include <fs/core/utils/config.hxx>
+
+namespace fs0 { namespace lookahead {
+
+std::unique_ptr<RewardBound>
+RewardBound::create(const fs0::Config& config, float discount) {
+	const float infinity = std::numeric_limits<float>::infinity();
+	float max_reward = config.getOption<float>("lookahead.bound.max_reward", infinity);
+	if ( max_reward == infinity ) return nullptr;
+	float max_terminal = config.getOption<float>("lookahead.bound.max_terminal", 0.0);
+	int depth = config.getOption<int>("lookahead.bound.max_depth", -1);
+	unsigned max_depth = ( depth >= 0 ) ? depth : std::numeric_limits<unsigned>::max();
+	return std::unique_ptr<RewardBound>(new RewardBound(max_reward, max_terminal, discount, max_depth));
+}
+
+RewardBound::RewardBound(float max_reward, float max_terminal, float discount, unsigned max_depth) :
+	_max_reward(max_reward),
+	_max_terminal(max_terminal),
+	_discount(discount),
+	_max_depth(max_depth)
+{
+	if ( _discount <= 0.0 )
+		throw std::runtime_error("[RewardBound] : the discount factor must be positive");
+}
+
+float
+RewardBound::descendants(float R, unsigned g) const {
+	const float infinity = std::numeric_limits<float>::infinity();
+	if ( g >= _max_depth ) return -infinity; // No descendants at all
+
+	// The descendants at depths g+1, ..., D accumulate d^k r(s_k) on top of R
+	float first = std::pow(_discount, g + 1) * _max_reward;
+	// With non-positive rewards, the best descendant is a child
+	if ( _max_reward <= 0.0 ) return R + first + _max_terminal;
+
+	bool unbounded_depth = ( _max_depth == std::numeric_limits<unsigned>::max() );
+	if ( unbounded_depth && _discount >= 1.0 ) return infinity;
+
+	float remaining;
+	if ( unbounded_depth ) remaining = first / (1.0 - _discount);
+	else if ( _discount == 1.0 ) remaining = ( _max_depth - g ) * _max_reward;
+	else remaining = first * (1.0 - std::pow(_discount, _max_depth - g)) / (1.0 - _discount);
+	return R + remaining + _max_terminal;
+}
+
+} } // namespaces
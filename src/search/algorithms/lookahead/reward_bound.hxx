@@ -0,0 +1,45 @@
+
+#pragma once
+
+#include <memory>
+
+namespace fs0 { class Config; }
+
+namespace fs0 { namespace lookahead {
+
+//! An optimistic bound on the value R+T of the descendants of a lookahead node, derived from
+//! an upper bound on the reward r(s) of a single state, an upper bound on the terminal reward
+//! T(s), the discount factor and, optionally, the maximum depth of the nodes that matter.
+//! Nodes whose descendants cannot beat the best node found so far need not be expanded.
+//! The bound is configured by the options 'lookahead.bound.*', and disabled by default.
+class RewardBound {
+public:
+	//! Returns nullptr unless 'lookahead.bound.max_reward' is set
+	static std::unique_ptr<RewardBound> create(const fs0::Config& config, float discount);
+
+	RewardBound(float max_reward, float max_terminal, float discount, unsigned max_depth);
+
+	//! An upper bound on R+T for any descendant of a node at depth g with accumulated reward R
+	float descendants(float R, unsigned g) const;
+
+	//! Returns true iff some descendant of a node at depth g with accumulated reward R might
+	//! have a value greater than 'incumbent'
+	bool can_improve(float R, unsigned g, float incumbent) const { return descendants(R, g) > incumbent; }
+
+	//! The depth beyond which nodes are not taken into account (the maximum unsigned value if none)
+	unsigned max_depth() const { return _max_depth; }
+
+protected:
+	//! Upper bound on r(s)
+	float _max_reward;
+
+	//! Upper bound on T(s)
+	float _max_terminal;
+
+	float _discount;
+
+	//! Nodes deeper than this are not taken into account, if set
+	unsigned _max_depth;
+};
+
+} } // namespaces
@@ -1,6 +1,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include <fs/core/search/drivers/sbfws/iw_run.hxx>
 #include <fs/core/search/drivers/sbfws/iw_run_config.hxx>
 #include <fs/core/search/drivers/registry.hxx>
@@ -14,6 +16,12 @@
 
 #include <fs/core/search/drivers/sbfws/stats.hxx>
 #include <fs/core/heuristics/reward.hxx>
+#include <search/algorithms/lookahead/batch_reward.hxx>
+#include <search/algorithms/lookahead/bucket_open_list.hxx>
+#include <search/algorithms/lookahead/discretization_schedule.hxx>
+#include <search/algorithms/lookahead/feature_valuation.hxx>
+#include <search/algorithms/lookahead/reward_bound.hxx>
+#include <search/algorithms/lookahead/transition_cache.hxx>
 #include <search/algorithms/lookahead/treelog.hxx>
 
 namespace fs0 { namespace lookahead {
@@ -36,6 +44,51 @@ struct unachieved_subgoals_comparer {
 	}
 };
 
+//! An open list sorted by #g which is either a binary heap ordered by 'unachieved_subgoals_comparer'
+//! or, if option 'bfws.bucket_queues' is set, an UnachievedBucketOpenList.
+template <typename NodeT, typename NodePT>
+class UnachievedOpenListSelector {
+protected:
+	using HeapT = lapkt::UpdatableOpenList<NodeT, NodePT, unachieved_subgoals_comparer<NodePT>>;
+	using BucketsT = UnachievedBucketOpenList<NodeT, NodePT>;
+
+	bool _use_buckets;
+	HeapT _heap;
+	BucketsT _buckets;
+
+public:
+	UnachievedOpenListSelector() : _use_buckets(false) {}
+
+	void use_buckets(bool value) {
+		assert(empty());
+		_use_buckets = value;
+	}
+
+	void insert(const NodePT& node) {
+		if (_use_buckets) _buckets.insert(node);
+		else _heap.insert(node);
+	}
+
+	NodePT next() {
+		return _use_buckets ? _buckets.next() : _heap.next();
+	}
+
+	bool empty() const { return _use_buckets ? _buckets.empty() : _heap.empty(); }
+
+	std::size_t size() const { return _use_buckets ? _buckets.size() : _heap.size(); }
+
+	bool contains(const NodePT& node) const { return _use_buckets ? _buckets.contains(node) : _heap.contains(node); }
+
+	void clear() {
+		if (_use_buckets) {
+			_buckets.clear();
+			return;
+		}
+		while (!_heap.empty())
+			_heap.next();
+	}
+};
+
 // ! Comparer taking into account #g and novelty
 template <typename NodePT>
 struct novelty_comparer {
@@ -98,8 +151,8 @@ public:
 
 	//! The number of atoms in the last relaxed plan computed in the way to the current state that have been
 	//! made true along the path (#r)
-	//! Use a raw pointer to optimize performance, as the number of generated nodes will typically be huge
-	RelevantAtomSet* _relevant_atoms;
+	//! The set is immutable once computed, and shared with the parent whenever the node reaches no new atom
+	std::shared_ptr<const RelevantAtomSet> _relevant_atoms;
 
 	//! #r
 	unsigned		_hash_r;
@@ -133,7 +186,7 @@ public:
 		assert(_gen_order > 0); // Very silly way to detect overflow, in case we ever generate > 4 billion nodes :-)
 	}
 
-	~SBFWSNode() { delete _helper; delete _relevant_atoms; }
+	~SBFWSNode() { delete _helper; }
 	SBFWSNode(const SBFWSNode&) = delete;
 	SBFWSNode(SBFWSNode&&) = delete;
 	SBFWSNode& operator=(const SBFWSNode&) = delete;
@@ -185,7 +238,12 @@ template <	typename StateModelT,
 			template <class S, class A> class SimNodeT >
 class SBFWSHeuristic {
 public:
-	using NoveltyEvaluatorMapT = std::unordered_map<long, NoveltyEvaluatorT*>;
+	//! A novelty evaluator along with the search epoch in which it was last reset
+	struct StampedEvaluator {
+		NoveltyEvaluatorT* evaluator;
+		unsigned long epoch;
+	};
+	using NoveltyEvaluatorMapT = std::unordered_map<long, StampedEvaluator>;
 	using ActionT = typename StateModelT::ActionType;
 	using IWNodeT =  SimNodeT<State, ActionT>;
 	using SimulationT =  SimulatorT<IWNodeT, StateModelT, NoveltyEvaluatorT, FeatureSetT>;
@@ -196,6 +254,7 @@ public:
 	using NoveltyEvaluatorPT = std::unique_ptr<NoveltyEvaluatorT>;
 
 	using FeatureValueT = typename NoveltyEvaluatorT::FeatureValueT;
+	using ValuationT = std::vector<FeatureValueT>;
 
 
 protected:
@@ -205,6 +264,10 @@ protected:
 
 	const FeatureSetT& _featureset;
 
+	//! The valuations of the node being evaluated and of its parent, reused across evaluations
+	ValuationT _valuation;
+	ValuationT _parent_valuation;
+
 	const NoveltyFactory<FeatureValueT> _search_novelty_factory;
 	const NoveltyFactory<FeatureValueT> _sim_novelty_factory;
 
@@ -231,6 +294,17 @@ protected:
 
 	SBFWSConfig _sbfwsconfig;
 
+	//! A scratch set where the set R of a node is computed before deciding whether it can share its parent's.
+	//! Its storage is reused while sets are shared, and handed over to the node when they are not.
+	std::unique_ptr<RelevantAtomSet> _scratch_R;
+
+	//! How many sets R have been shared with the parent node rather than copied
+	unsigned long _num_shared_R;
+
+	//! The current search. Novelty evaluators stamped with an older epoch are reset the first time they are
+	//! fetched in the current search, so that tables which are not used again are never cleared
+	unsigned long _epoch;
+
 
 public:
 	SBFWSHeuristic(const SBFWSConfig& config, const Config& c, const StateModelT& model, const FeatureSetT& features, BFWSStats& stats) :
@@ -250,7 +324,10 @@ public:
 				   config.simulation_width,
 					c),
 		_stats(stats),
-		_sbfwsconfig(config)
+		_sbfwsconfig(config),
+		_scratch_R(nullptr),
+		_num_shared_R(0),
+		_epoch(0)
 	{
 		if (_sbfwsconfig.relevant_set_type == SBFWSConfig::RelevantSetType::L0 )
 			_l0_heuristic = std::make_shared<L0Heuristic>(_problem);
@@ -259,18 +336,14 @@ public:
 	}
 
 	~SBFWSHeuristic() {
-		for (auto& elem:_wg_novelty_evaluators) for (auto& p:elem) delete p.second;
-		for (auto& elem:_wgr_novelty_evaluators) for (auto& p:elem) delete p.second;
+		for (auto& elem:_wg_novelty_evaluators) for (auto& p:elem) delete p.second.evaluator;
+		for (auto& elem:_wgr_novelty_evaluators) for (auto& p:elem) delete p.second.evaluator;
 	};
 
 	void
 	reset() {
-		for ( unsigned i = 0; i < _wg_novelty_evaluators.size(); i++ )
-			for ( auto entry :  _wg_novelty_evaluators[i] )
-				entry.second->reset();
-		for ( unsigned i = 0; i < _wgr_novelty_evaluators.size(); i++ )
-			for ( auto entry :  _wgr_novelty_evaluators[i] )
-				entry.second->reset();
+		_num_shared_R = 0;
+		++_epoch;
 	}
 
 	template <typename NodeT>
@@ -367,11 +440,16 @@ public:
 	NoveltyEvaluatorT* fetch_evaluator(NoveltyEvaluatorMapT& evaluator_map,  unsigned k, unsigned type) {
 		auto it = evaluator_map.find(type);
 		if (it == evaluator_map.end()) {
-			auto inserted = evaluator_map.insert(std::make_pair(type, _search_novelty_factory.create_evaluator(k)));
+			auto inserted = evaluator_map.insert(std::make_pair(type, StampedEvaluator{_search_novelty_factory.create_evaluator(k), _epoch}));
 			_stats.search_table_created(k);
 			it = inserted.first;
 		}
-		return it->second;
+		StampedEvaluator& entry = it->second;
+		if (entry.epoch != _epoch) {
+			entry.evaluator->reset();
+			entry.epoch = _epoch;
+		}
+		return entry.evaluator;
 	}
 
 	template <typename NodeT>
@@ -380,15 +458,18 @@ public:
 
 		if (node.has_parent() && type == parent_type) {
 			// Important: the novel-based computation works only when the parent has the same novelty type and thus goes against the same novelty tables!!!
-			return evaluator->evaluate(_featureset.evaluate(node.state), _featureset.evaluate(node.parent->state), k);
+			evaluate_features(_featureset, node.state, _valuation);
+			evaluate_features(_featureset, node.parent->state, _parent_valuation);
+			return evaluator->evaluate(_valuation, _parent_valuation, k);
 		}
 
-		return evaluator->evaluate(_featureset.evaluate(node.state), k);
+		evaluate_features(_featureset, node.state, _valuation);
+		return evaluator->evaluate(_valuation, k);
 	}
 
 	//! Compute the RelevantAtomSet that corresponds to the given node, and from which
 	//! the counter #r(node) can be obtained. This implements a lazy version which
-	//! can recursively compute the parent RelevantAtomSet.
+	//! computes first the sets of those ancestors that have not been computed yet.
 	//! Additionally, this caches the set within the node for future reference.
 	template <typename NodeT>
 	const RelevantAtomSet& compute_R(NodeT& node) {
@@ -396,58 +477,99 @@ public:
 		// If the R(s) has been previously computed and is cached, we return it straight away
 		if (node._relevant_atoms != nullptr) return *node._relevant_atoms;
 
+		// Otherwise, we walk up the path until we find a node whose set is known or needs to be computed
+		// from scratch, and then compute the sets of all nodes in the path top-down. This avoids a
+		// recursion as deep as the path
+		std::vector<NodeT*> path;
+		NodeT* current = &node;
+		while (current->_relevant_atoms == nullptr) {
+			path.push_back(current);
+			if (computation_of_R_necessary(*current)) break;
+			current = current->parent.get();
+		}
+
+		for (auto it = path.rbegin(); it != path.rend(); ++it) {
+			if (computation_of_R_necessary(**it)) compute_R_from_simulation(**it);
+			else compute_R_from_parent(**it);
+		}
 
-		// Otherwise, we compute it anew
-		if (computation_of_R_necessary(node)) {
+		return *node._relevant_atoms;
+	}
 
-			// Throw a simulation from the node, and compute a set R[IW1] from there.
-			bool verbose = !node.has_parent(); // Print info only on the s0 simulation
-			auto evaluator = _sim_novelty_factory.create_compound_evaluator(_sbfwsconfig.simulation_width);
-			// TODO Fix this horrible hack
-			if (_sbfwsconfig.simulation_width==2) { _stats.sim_table_created(1); _stats.sim_table_created(2); }
-			else  { assert(_sbfwsconfig.simulation_width); _stats.sim_table_created(1); }
+	//! Throw a simulation from the node, and compute a set R[IW1] from there.
+	template <typename NodeT>
+	void compute_R_from_simulation(NodeT& node) {
+		bool verbose = !node.has_parent(); // Print info only on the s0 simulation
+		auto evaluator = _sim_novelty_factory.create_compound_evaluator(_sbfwsconfig.simulation_width);
+		// TODO Fix this horrible hack
+		if (_sbfwsconfig.simulation_width==2) { _stats.sim_table_created(1); _stats.sim_table_created(2); }
+		else  { assert(_sbfwsconfig.simulation_width); _stats.sim_table_created(1); }
 
 
-			SimulationT simulator(_model, _featureset, evaluator, _simconfig, _stats, verbose);
+		SimulationT simulator(_model, _featureset, evaluator, _simconfig, _stats, verbose);
 
 
-			node._helper = new AtomsetHelper(_problem.get_tuple_index(), simulator.compute_R(node.state));
-			node._relevant_atoms = new RelevantAtomSet(*node._helper);
+		node._helper = new AtomsetHelper(_problem.get_tuple_index(), simulator.compute_R(node.state));
+		auto relevant = std::make_shared<RelevantAtomSet>(*node._helper);
 
-			//! MRJ: over states
-			// node._relevant_atoms->init(node.state);
-			//! Over feature sets
-			node._relevant_atoms->init(_featureset.evaluate(node.state));
+		//! MRJ: over states
+		// relevant->init(node.state);
+		//! Over feature sets
+		evaluate_features(_featureset, node.state, _valuation);
+		relevant->init(_valuation);
+		node._relevant_atoms = relevant;
 
-			if (!node.has_parent()) { // Log some info, but only for the seed state
-				LPT_DEBUG("cout", "R(s_0)  (#=" << node._relevant_atoms->getHelper()._num_relevant << "): " << std::endl << *(node._relevant_atoms));
-			}
+		if (!node.has_parent()) { // Log some info, but only for the seed state
+			LPT_DEBUG("cout", "R(s_0)  (#=" << node._relevant_atoms->getHelper()._num_relevant << "): " << std::endl << *(node._relevant_atoms));
 		}
+	}
 
-
-		else {
-			// Copy the set R from the parent and update the set of relevant nodes with those that have been reached.
-			node._relevant_atoms = new RelevantAtomSet(compute_R(*node.parent)); // This might trigger a recursive computation
-
-			if (node.decreases_unachieved_subgoals()) {
-				//! MRJ:
-				//! Over states
-				//node._relevant_atoms->init(node.state); // THIS IS ABSOLUTELY KEY E.G. IN BARMAN
-				//! MRJ:  Over feature sets
-				node._relevant_atoms->init(_featureset.evaluate(node.state));
-			} else {
-				//! MRJ: Over states
-				//! node._relevant_atoms->update(node.state, nullptr);
-				//! Old, deprecated use
-				// node._relevant_atoms->update(node.state, &(node.parent->state));
-				//! MRJ: Over feature sets
-				node._relevant_atoms->update(_featureset.evaluate(node.state));
-			}
+	//! Update the set R of the parent with the atoms that have been reached by the node. The sets R only grow
+	//! along a path, hence if the number of reached atoms does not change, neither does the set, and the node
+	//! can share the parent's set instead of holding its own copy. Since RelevantAtomSet can only be updated as
+	//! a whole, the parent's set is copied into a scratch set first, which then becomes the node's set if it did
+	//! change, so every node still costs one copy, as it did before sets were shared. Nodes that decrease #g
+	//! compute their set from scratch, without any copy of the parent's.
+	template <typename NodeT>
+	void compute_R_from_parent(NodeT& node) {
+		const auto& parent_R = node.parent->_relevant_atoms;
+		assert(parent_R != nullptr);
+
+		if (node.decreases_unachieved_subgoals()) {
+			auto relevant = std::make_shared<RelevantAtomSet>(parent_R->getHelper());
+			//! MRJ:
+			//! Over states
+			//relevant->init(node.state); // THIS IS ABSOLUTELY KEY E.G. IN BARMAN
+			//! MRJ:  Over feature sets
+			evaluate_features(_featureset, node.state, _valuation);
+			relevant->init(_valuation);
+			node._relevant_atoms = relevant;
+			return;
 		}
 
-		return *node._relevant_atoms;
+		if (_scratch_R == nullptr) _scratch_R.reset(new RelevantAtomSet(*parent_R));
+		else *_scratch_R = *parent_R;
+
+		//! MRJ: Over states
+		//! _scratch_R->update(node.state, nullptr);
+		//! Old, deprecated use
+		// _scratch_R->update(node.state, &(node.parent->state));
+		//! MRJ: Over feature sets
+		evaluate_features(_featureset, node.state, _valuation);
+		_scratch_R->update(_valuation);
+
+		if (_scratch_R->num_reached() == parent_R->num_reached()) {
+			node._relevant_atoms = parent_R;
+			++_num_shared_R;
+			return;
+		}
+		// The node takes over the scratch set, which will be allocated again when next needed
+		node._relevant_atoms = std::shared_ptr<RelevantAtomSet>(std::move(_scratch_R));
 	}
 
+	//! The number of nodes in the last search that share the set R of their parent
+	unsigned long num_shared_R() const { return _num_shared_R; }
+
 	template <typename NodeT>
 	unsigned compute_R_via_L0(NodeT& node) {
 		unsigned v =  _l0_heuristic->evaluate(node.state);
@@ -500,13 +622,13 @@ public:
 	using SimulationNodeT = typename HeuristicT::IWNodeT;
 	using SimulationNodePT = typename HeuristicT::IWNodePT;
 	using RewardPT = std::shared_ptr<Reward>;
+	using BatchRewardPT = std::shared_ptr<BatchReward>;
 
 	std::vector<NodePT> _visited;
 protected:
 
 // An open list sorted by #g
-	using UnachievedSubgoalsComparerT = unachieved_subgoals_comparer<NodePT>;
-	using UnachievedOpenList = lapkt::UpdatableOpenList<NodeT, NodePT, UnachievedSubgoalsComparerT>;
+	using UnachievedOpenList = UnachievedOpenListSelector<NodeT, NodePT>;
 
 	//! An open list sorted by the numerical value of width, then #g
 	using NoveltyComparerT = novelty_comparer<NodePT>;
@@ -569,6 +691,32 @@ protected:
     // MRJ: Reward Function
 	RewardPT	_reward_function;
 
+	//! Batched reward function, used instead of _reward_function to compute r(s) when set
+	BatchRewardPT	_batch_reward;
+
+	//! Buffers for the batched evaluation of the successors of a node
+	std::vector<NodePT> _successors;
+	std::vector<const StateT*> _batch_states;
+	std::vector<float> _batch_rewards;
+
+	//! The integration step schedule
+	DiscretizationSchedule _schedule;
+
+	//! Transitions memoized across searches, if any
+	std::shared_ptr<TransitionCache> _transitions;
+
+	//! Raised by some other thread when the search must stop and return the best plan found so far
+	const std::atomic<bool>* _cancelled;
+
+	//! Whether to stay silent during the search, e.g. when other engines search concurrently
+	bool _quiet;
+
+	//! The bound on the value of the descendants of a node, if reward-bound pruning is enabled
+	std::unique_ptr<RewardBound> _bound;
+
+	//! The number of nodes not expanded because no descendant could beat the best node
+	unsigned long _num_bound_pruned;
+
 	// Horizon
 	float 		_horizon;
 	VariableIdx	_clock_var;
@@ -598,10 +746,22 @@ public:
 		_min_subgoals_to_reach(std::numeric_limits<unsigned>::max()),
 		_novelty_levels(setup_novelty_levels(model, config)),
         _reward_function(nullptr),
+		_batch_reward(nullptr),
+		_schedule(config),
+		_transitions(nullptr),
+		_cancelled(nullptr),
+		_quiet(false),
+		_bound(nullptr),
+		_num_bound_pruned(0),
 		_horizon( config.getHorizonTime() ),
 		_discount(config.getOption<float>("lookahead.bfws.discount", 1.0))
 	{
+		_bound = RewardBound::create(config, _discount);
 		_clock_var = ProblemInfo::getInstance().getVariableId("clock_time()");
+
+		bool bucket_queues = config.getOption<bool>("bfws.bucket_queues", false);
+		for (UnachievedOpenList* q:{&_q1, &_qwgr1, &_qwgr2, &_qrest})
+			q->use_buckets(bucket_queues);
 	}
 
 	~SBFWS() = default;
@@ -612,6 +772,10 @@ public:
 
 	NodePT get_best_node() const { return _best_node; }
 
+	const HeuristicT& get_heuristic() const { return _heuristic; }
+
+	unsigned long num_bound_pruned() const { return _num_bound_pruned; }
+
 	unsigned setup_novelty_levels(const StateModelT& model, const Config& config) const {
 		const AtomIndex& atomidx = model.getTask().get_tuple_index();
 
@@ -653,16 +817,57 @@ public:
 	}
 
 
+	//!
+	void set_batch_reward( BatchRewardPT f ) {
+		_batch_reward = f;
+	}
+
+	//! Memoize the transitions of the search in the given cache
+	void set_transition_cache( std::shared_ptr<TransitionCache> cache ) {
+		_transitions = cache;
+	}
+
+	//! Stop the search as soon as the given flag is raised
+	void set_cancellation_flag( const std::atomic<bool>* flag ) {
+		_cancelled = flag;
+	}
+
+	//! Do not log anything during the search
+	void set_quiet( bool quiet ) {
+		_quiet = quiet;
+	}
+
+	bool cancelled() const {
+		return _cancelled != nullptr && _cancelled->load(std::memory_order_relaxed);
+	}
+
 	//! Evaluate reward
 	void evaluate_reward( NodePT n ) const {
+		if ( _batch_reward != nullptr ) {
+			accumulate_reward(n, _batch_reward->evaluate(n->state));
+			return;
+		}
 		if ( _reward_function == nullptr ) {
 			n->R = 0.0f;
 			return;
 		}
-		n->R = std::pow(_discount,n->g)*_reward_function->evaluate(n->state);
+		accumulate_reward(n, _reward_function->evaluate(n->state));
+	}
+
+	//! Evaluate the reward of all the given nodes with a single call to the batched reward function
+	void evaluate_reward_batch( const std::vector<NodePT>& nodes ) {
+		_batch_states.clear();
+		for ( const auto& n : nodes ) _batch_states.push_back(&(n->state));
+		_batch_reward->evaluate(_batch_states, _batch_rewards);
+		for ( unsigned i = 0; i < nodes.size(); i++ )
+			accumulate_reward(nodes[i], _batch_rewards[i]);
+	}
+
+	//! Discount r(s) and accumulate it along the path to the node
+	void accumulate_reward( NodePT n, float r ) const {
+		n->R = std::pow(_discount,n->g)*r;
 		if ( n->parent != nullptr )
 			n->R += n->parent->R;
-		return;
 	}
 
 	void evaluate_terminal_cost( NodePT n ) const {
@@ -677,31 +882,29 @@ public:
 	bool solve_model(PlanT& solution) { return search(_model.init(), solution); }
 
 	bool search(const StateT& s, PlanT& plan) {
+		DiscretizationSchedule::Scope schedule_scope(_schedule);
 		_min_subgoals_to_reach =std::numeric_limits<unsigned>::max();
 		_solution = nullptr;
 		_best_node = nullptr;
 		_non_terminal_best_node = nullptr;
-		while ( !_q1.empty() )
-			_q1.next();
-		while ( !_qwgr1.empty() )
-			_qwgr1.next();
-		while ( !_qwgr2.empty() )
-			_qwgr2.next();
-		while ( !_qrest.empty() )
-			_qrest.next();
+		_q1.clear();
+		_qwgr1.clear();
+		_qwgr2.clear();
+		_qrest.clear();
 		_closed.clear();
 		_generated = 0;
 		_visited.clear();
 		_heuristic.reset();
 		_stats.reset_generations();
+		_num_bound_pruned = 0;
 
 		NodePT root = std::make_shared<NodeT>(s, ++_generated);
 		create_node(root);
-		LPT_INFO("search", "Search root node: " << *root);
-		LPT_INFO("search", "R(root)=" << _reward_function->evaluate(root->state));
-		LPT_INFO("search", "T(root)=" << _reward_function->terminal(root->state));
-		LPT_INFO("search", "Pruning s s.t. w(s) > 2?" << _pruning );
-		LPT_INFO("search", "Max Generations:" << _max_generations );
+		if (!_quiet) LPT_INFO("search", "Search root node: " << *root);
+		if (!_quiet) LPT_INFO("search", "R(root)=" << _reward_function->evaluate(root->state));
+		if (!_quiet) LPT_INFO("search", "T(root)=" << _reward_function->terminal(root->state));
+		if (!_quiet) LPT_INFO("search", "Pruning s s.t. w(s) > 2?" << _pruning );
+		if (!_quiet) LPT_INFO("search", "Max Generations:" << _max_generations );
 
 		_stats.set_initial_reward(root->R);
 		assert(_q1.size()==1); // The root node must necessarily have novelty 1
@@ -711,16 +914,16 @@ public:
 			remaining_nodes = process_one_node();
 		}
 		// Dump optimal_paths and visited into JSON document
-		LPT_INFO("search", "Call to BFWS finished, generated=" << _stats.generated());
+		if (!_quiet) LPT_INFO("search", "Call to BFWS finished, generated=" << _stats.generated());
 		if ( _best_node == nullptr && _non_terminal_best_node == nullptr ) {
 			throw std::runtime_error("SBFWS::search() : No best node was selected!");
 		}
 		if ( _best_node == nullptr && _non_terminal_best_node != nullptr ) {
-			LPT_INFO("search", "Terminal nodes weren't reached or were poor quality, returning best non terminal!");
+			if (!_quiet) LPT_INFO("search", "Terminal nodes weren't reached or were poor quality, returning best non terminal!");
 			_best_node = _non_terminal_best_node;
 		}
-		LPT_INFO("search", "Best R(s): " << _best_node->R << " Best T(s): " << _best_node->T << " depth: " << _best_node->g );
-		LPT_INFO("search", "Best: " << *_best_node );
+		if (!_quiet) LPT_INFO("search", "Best R(s): " << _best_node->R << " Best T(s): " << _best_node->T << " depth: " << _best_node->g );
+		if (!_quiet) LPT_INFO("search", "Best: " << *_best_node );
 		if (_log_search)
 			dump_search_tree( *this, "bfws.lookahead.json");
 		if ( _solution == nullptr )
@@ -753,7 +956,7 @@ protected:
 	//! Returns true if some action has been performed, false if all queues were empty
 	bool process_one_node() {
 		///// Q1 QUEUE /////
-		if ( _stats.generated() >= _max_generations )
+		if ( _stats.generated() >= _max_generations || cancelled() )
 			return false;
 		// First process nodes with w_{#g}=1
 		if (_lazy_iw_1_search && !_q1.empty()) {
@@ -839,28 +1042,25 @@ protected:
 	//! When opening a node, we compute #g and evaluates whether the given node has <#g>-novelty 1 or not;
 	//! if that is the case, we insert it into a special queue.
 	//! Returns true iff the newly-created node is a solution
-	bool create_node(const NodePT& node) {
+	bool create_node(const NodePT& node, bool reward_evaluated = false) {
+		if (!reward_evaluated) evaluate_reward(node);
+		evaluate_terminal_cost(node);
+
 		if (is_goal(node) ) {
-			evaluate_reward(node);
-			evaluate_terminal_cost(node);
 			update_best_node(node, _best_node, false);
 			if (_log_search )
 				_visited.push_back(node);
-			LPT_INFO("search", "Goal node was found, R(s) = " << node->R << ", T(s) = " << node->T << " generated=" << _stats.generated() << ", best R=" << _best_node->R << ", best T=" << _best_node->T);
+			if (!_quiet) LPT_INFO("search", "Goal node was found, R(s) = " << node->R << ", T(s) = " << node->T << " generated=" << _stats.generated() << ", best R=" << _best_node->R << ", best T=" << _best_node->T);
 			_solution = node;
 			return true;
 		}
 		if (is_terminal(node)) {
-			evaluate_reward(node);
-			evaluate_terminal_cost(node);
 			update_best_node(node, _best_node, false);
 			if (_log_search )
 				_visited.push_back(node);
-			LPT_INFO("search", "Terminal node was found, R(s) = " << node->R << ", T(s) = " << node->T << " generated=" << _stats.generated() << ", best R=" << _best_node->R << ", best T=" << _best_node->T);
+			if (!_quiet) LPT_INFO("search", "Terminal node was found, R(s) = " << node->R << ", T(s) = " << node->T << " generated=" << _stats.generated() << ", best R=" << _best_node->R << ", best T=" << _best_node->T);
 			return false;
 		}
-		evaluate_reward(node);
-		evaluate_terminal_cost(node);
 
 		update_best_node(node, _non_terminal_best_node, true);
 
@@ -868,7 +1068,7 @@ protected:
 
 		if (node->unachieved_subgoals < _min_subgoals_to_reach) {
 			_min_subgoals_to_reach = node->unachieved_subgoals;
-			LPT_INFO("search", "Min. # unreached subgoals: " << _min_subgoals_to_reach << "/" << _model.num_subgoals());
+			if (!_quiet) LPT_INFO("search", "Min. # unreached subgoals: " << _min_subgoals_to_reach << "/" << _model.num_subgoals());
 		}
 
 		// Now insert the node into the appropriate queues
@@ -899,18 +1099,33 @@ protected:
 		//assert(!node->_processed); // Don't process a node twice!
 		node->_processed = true; // Mark the node as processed
 		_closed.put(node);
+		if (!can_improve(node)) return;
 		expand_node(node);
 	}
 
+	//! Returns false iff reward-bound pruning is enabled and no descendant of the node can have a greater
+	//! R+T than the best goal or terminal node so far
+	bool can_improve(const NodePT& node) {
+		if (!_bound || _best_node == nullptr) return true;
+		if (_bound->can_improve(node->R, node->g, _best_node->R + _best_node->T)) return true;
+		++_num_bound_pruned;
+		return false;
+	}
+
 	// Return true iff at least one node was created
 	void expand_node(const NodePT& node) {
 		//LPT_INFO("search", *node);
 		_stats.expansion();
 		if (node->decreases_unachieved_subgoals()) _stats.expansion_g_decrease();
 
+		if (_batch_reward != nullptr) {
+			expand_node_batched(node);
+			return;
+		}
+
 		for (const auto& action:_model.applicable_actions(node->state, true)) {
 			// std::cout << *(Problem::getInstance().getGroundActions()[action]) << std::endl;
-			StateT s_a = _model.next(node->state, action);
+			StateT s_a = successor(node->state, action, node->g);
 			NodePT successor = std::make_shared<NodeT>(std::move(s_a), action, node, ++_generated);
 
 			if (_closed.check(successor)) continue; // The node has already been closed
@@ -922,6 +1137,35 @@ protected:
 		}
 	}
 
+	//! As expand_node, but all successors are generated before scoring them with a single call
+	//! to the batched reward function.
+	void expand_node_batched(const NodePT& node) {
+		_successors.clear();
+		for (const auto& action:_model.applicable_actions(node->state, true)) {
+			StateT s_a = successor(node->state, action, node->g);
+			NodePT successor = std::make_shared<NodeT>(std::move(s_a), action, node, ++_generated);
+
+			if (_closed.check(successor)) continue; // The node has already been closed
+			if (is_open(successor)) continue; // The node is currently on (some) open list, so we ignore it
+			_successors.push_back(successor);
+		}
+
+		evaluate_reward_batch(_successors);
+		for (const auto& successor : _successors) {
+			if (is_open(successor)) continue; // Some other successor of the same node led to the same state
+			if (create_node(successor, true)) {
+				break;
+			}
+		}
+	}
+
+	//! The successor of a state at depth g, integrated with the step given by the schedule
+	StateT successor(const StateT& s, const ActionIdT& a, unsigned g) {
+		if (_schedule.enabled()) _schedule.apply(g);
+		if (_transitions) return _transitions->next(_model, s, a);
+		return _model.next(s, a);
+	}
+
 	bool is_open(const NodePT& node) const {
 		return _q1.contains(node) ||
 		       _qwgr1.contains(node) ||
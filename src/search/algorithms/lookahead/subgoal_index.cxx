@@ -0,0 +1,66 @@
+
+#include <search/algorithms/lookahead/subgoal_index.hxx>
+
+#include <algorithm>
+
+#include <fs/core/problem.hxx>
+#include <fs/core/problem_info.hxx>
+#include <fs/core/state.hxx>
+#include <fs/core/languages/fstrips/language.hxx>
+#include <fs/core/languages/fstrips/operations.hxx>
+#include <lapkt/tools/logging.hxx>
+
+namespace fs0 { namespace lookahead {
+
+std::unique_ptr<SubgoalIndex>
+SubgoalIndex::create(const Problem& problem, unsigned num_subgoals) {
+	// Subgoals are the conjuncts of the goal formula, see SimpleStateModel
+	const fs::Formula* goal = problem.getGoalConditions();
+	const fs::Conjunction* conjunction = dynamic_cast<const fs::Conjunction*>(goal);
+	if ( conjunction == nullptr || conjunction->getSubformulae().size() != num_subgoals ) {
+		LPT_INFO("search", "SubgoalIndex::create() : goal formula does not decompose into " << num_subgoals << " subgoals, subgoals will be checked exhaustively");
+		return nullptr;
+	}
+
+	std::unique_ptr<SubgoalIndex> index(new SubgoalIndex(ProblemInfo::getInstance().getNumVariables(), num_subgoals));
+	const auto& subgoals = conjunction->getSubformulae();
+	for ( unsigned i = 0; i < subgoals.size(); ++i ) {
+		if ( !fs::all_nodes<fs::FluentHeadedNestedTerm>(*subgoals[i]).empty() ) {
+			index->_always.push_back(i);
+			continue;
+		}
+		for ( const fs::StateVariable* sv : fs::all_nodes<fs::StateVariable>(*subgoals[i]) ) {
+			auto& entry = index->_index[sv->getValue()];
+			if ( entry.empty() || entry.back() != i ) entry.push_back(i);
+		}
+	}
+	LPT_INFO("search", "SubgoalIndex::create() : " << index->_always.size() << " out of " << num_subgoals << " subgoals have no static scope");
+	return index;
+}
+
+SubgoalIndex::SubgoalIndex(unsigned num_variables, unsigned num_subgoals) :
+	_index(num_variables),
+	_always(),
+	_stamp(num_subgoals, 0),
+	_current(0)
+{}
+
+void
+SubgoalIndex::touched(const State& s, const State& parent, std::vector<unsigned>& subgoals) {
+	subgoals = _always;
+	if ( ++_current == 0 ) { // Stamps wrapped around
+		std::fill(_stamp.begin(), _stamp.end(), 0);
+		_current = 1;
+	}
+
+	for ( VariableIdx x = 0; x < _index.size(); ++x ) {
+		if ( _index[x].empty() || s.getValue(x) == parent.getValue(x) ) continue;
+		for ( unsigned i : _index[x] ) {
+			if ( _stamp[i] == _current ) continue;
+			_stamp[i] = _current;
+			subgoals.push_back(i);
+		}
+	}
+}
+
+} } // namespaces
@@ -0,0 +1,41 @@
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <fs/core/fs_types.hxx>
+
+namespace fs0 { class Problem; class State; }
+
+namespace fs0 { namespace lookahead {
+
+//! Indexes the subgoals of a problem (i.e. the conjuncts of its goal formula, in the same
+//! order as SimpleStateModel::goal(s, i)) by the state variables their truth value depends on,
+//! so that when a state differs from its parent in a few variables only the subgoals that
+//! mention them need to be re-checked.
+class SubgoalIndex {
+public:
+	//! Returns nullptr if the goal of the problem does not decompose into 'num_subgoals' conjuncts
+	static std::unique_ptr<SubgoalIndex> create(const Problem& problem, unsigned num_subgoals);
+
+	//! Computes into 'subgoals' the (non-repeated) indexes of the subgoals whose truth value might
+	//! differ between states 's' and 'parent'
+	void touched(const State& s, const State& parent, std::vector<unsigned>& subgoals);
+
+protected:
+	SubgoalIndex(unsigned num_variables, unsigned num_subgoals);
+
+	//! _index[x] contains the subgoals that mention state variable x
+	std::vector<std::vector<unsigned>> _index;
+
+	//! Subgoals whose scope cannot be determined statically (e.g. because of nested fluents),
+	//! which are always touched
+	std::vector<unsigned> _always;
+
+	//! _stamp[i] == _current iff subgoal i has already been collected in the current call to 'touched'
+	std::vector<unsigned> _stamp;
+	unsigned _current;
+};
+
+} } // namespaces
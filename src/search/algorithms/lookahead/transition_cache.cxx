@@ -0,0 +1,97 @@
+
+#include <search/algorithms/lookahead/transition_cache.hxx>
+
+#include <algorithm>
+
+#include <boost/functional/hash.hpp>
+
+#include <fs/core/problem_info.hxx>
+#include <fs/core/utils/config.hxx>
+#include <lapkt/tools/logging.hxx>
+
+namespace fs0 { namespace lookahead {
+
+std::size_t
+TransitionCache::KeyHasher::operator()(const Key& k) const {
+	std::size_t seed = static_cast<std::size_t>(k.fingerprint);
+	boost::hash_combine(seed, k.action);
+	boost::hash_combine(seed, k.step);
+	boost::hash_combine(seed, k.zcc);
+	return seed;
+}
+
+TransitionCache::TransitionCache(const ProblemInfo& info, unsigned capacity, float tolerance, unsigned num_shards) :
+	_fingerprinter(info, tolerance),
+	_shard_capacity(std::max(1u, capacity / std::max(1u, num_shards))),
+	_shards(),
+	_hits(0),
+	_misses(0)
+{
+	for ( unsigned i = 0; i < std::max(1u, num_shards); i++ )
+		_shards.push_back(std::unique_ptr<Shard>(new Shard()));
+}
+
+std::shared_ptr<TransitionCache>
+TransitionCache::create(const Config& config, const ProblemInfo& info) {
+	int capacity = config.getOption<int>("lookahead.transition_cache.size", 0);
+	if ( capacity <= 0 ) return nullptr;
+	float tolerance = config.getOption<float>("lookahead.transition_cache.tolerance", 0.0);
+	LPT_INFO("search", "Caching up to " << capacity << " transitions across searches (tolerance: " << tolerance << ")");
+	return std::make_shared<TransitionCache>(info, capacity, tolerance);
+}
+
+State
+TransitionCache::next(const SimpleStateModel& model, const State& s, ActionIdT a) {
+	const fs0::Config& config = fs0::Config::instance();
+	Key key{ _fingerprinter.compute(s), a, config.getDiscretizationStep(), config.getZeroCrossingControl() };
+	bool exact = _fingerprinter.tolerance() <= 0.0f;
+	Shard& sh = shard(key);
+
+	{
+		std::lock_guard<std::mutex> lock(sh.mutex);
+		auto it = sh.table.find(key);
+		if ( it != sh.table.end() && (!exact || *(it->second.source) == s) ) {
+			++_hits;
+			return State(*(it->second.next));
+		}
+	}
+
+	// Integrate outside of the critical section
+	++_misses;
+	auto successor = std::make_shared<const State>(model.next(s, a));
+
+	std::lock_guard<std::mutex> lock(sh.mutex);
+	auto inserted = sh.table.insert(std::make_pair(key, Entry{ exact ? std::make_shared<const State>(s) : nullptr, successor }));
+	if ( inserted.second ) {
+		sh.order.push_back(key);
+		if ( sh.order.size() > _shard_capacity ) {
+			sh.table.erase(sh.order.front());
+			sh.order.pop_front();
+		}
+	} else if ( exact ) {
+		// A colliding state was cached under the same fingerprint, keep the most recent one
+		inserted.first->second = Entry{ std::make_shared<const State>(s), successor };
+	}
+	return State(*successor);
+}
+
+void
+TransitionCache::clear() {
+	for ( auto& sh : _shards ) {
+		std::lock_guard<std::mutex> lock(sh->mutex);
+		sh->table.clear();
+		sh->order.clear();
+	}
+}
+
+std::size_t
+TransitionCache::size() const {
+	std::size_t total = 0;
+	for ( const auto& sh : _shards ) {
+		std::lock_guard<std::mutex> lock(sh->mutex);
+		total += sh->table.size();
+	}
+	return total;
+}
+
+} } // namespaces
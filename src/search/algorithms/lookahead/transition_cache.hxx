@@ -0,0 +1,87 @@
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <fs/core/models/simple_state_model.hxx>
+#include <search/algorithms/lookahead/fingerprint.hxx>
+
+namespace fs0 { class Config; class ProblemInfo; }
+
+namespace fs0 { namespace lookahead {
+
+//! A bounded memo table of transitions s -> next(s, a), meant to be kept across
+//! successive lookahead searches, which typically regenerate many of the transitions of
+//! the previous ones. Entries are keyed on the fingerprint of the source state, the
+//! action, the integration step and the zero crossing control setting, so changing any of
+//! the latter never returns stale successors. With a zero tolerance, fingerprint collisions
+//! are ruled out by comparing the source states; with a positive one, float variables are
+//! quantised and any state in the same cell is taken to have the same successor.
+//! The table is split into shards, each guarded by its own mutex, so that it can be shared
+//! by concurrent searches. Each shard evicts its entries in FIFO order.
+class TransitionCache {
+public:
+	using ActionIdT = SimpleStateModel::ActionType::IdType;
+
+	TransitionCache(const ProblemInfo& info, unsigned capacity, float tolerance, unsigned num_shards = 16);
+
+	//! Returns the cache configured by the 'lookahead.transition_cache.*' options, or nullptr if disabled
+	static std::shared_ptr<TransitionCache> create(const Config& config, const ProblemInfo& info);
+
+	//! Returns next(s, a) in the given model, computing and storing it if not already cached
+	State next(const SimpleStateModel& model, const State& s, ActionIdT a);
+
+	void clear();
+
+	void reset_stats() { _hits = 0; _misses = 0; }
+
+	unsigned long hits() const { return _hits; }
+	unsigned long misses() const { return _misses; }
+	std::size_t size() const;
+
+protected:
+	struct Key {
+		uint64_t fingerprint;
+		ActionIdT action;
+		double step;
+		bool zcc;
+
+		bool operator==(const Key& o) const {
+			return fingerprint == o.fingerprint && action == o.action && step == o.step && zcc == o.zcc;
+		}
+	};
+
+	struct KeyHasher { std::size_t operator()(const Key& k) const; };
+
+	struct Entry {
+		//! The source state, only stored when the tolerance is zero
+		std::shared_ptr<const State> source;
+		std::shared_ptr<const State> next;
+	};
+
+	struct Shard {
+		std::mutex mutex;
+		std::unordered_map<Key, Entry, KeyHasher> table;
+		std::deque<Key> order;
+	};
+
+	StateFingerprinter _fingerprinter;
+
+	//! Maximum number of entries per shard
+	unsigned _shard_capacity;
+
+	std::vector<std::unique_ptr<Shard>> _shards;
+
+	std::atomic<unsigned long> _hits;
+	std::atomic<unsigned long> _misses;
+
+	Shard& shard(const Key& key) { return *_shards[KeyHasher()(key) % _shards.size()]; }
+};
+
+} } // namespaces
@@ -6,9 +6,7 @@
 #include <fs/core/search/drivers/setups.hxx>
 #include <fs/core/search/utils.hxx>
 
-#include <fs/core/heuristics/goal_count_signal.hxx>
-#include <fs/core/heuristics/error_signal.hxx>
-#include <fs/core/heuristics/metric_signal.hxx>
+#include <search/drivers/online/rewards.hxx>
 
 #include <fs/core/search/novelty/fs_novelty.hxx>
 
@@ -17,44 +15,48 @@
 
 namespace fs0 { namespace drivers { namespace online {
 
-IteratedWidthDriver::~IteratedWidthDriver() {}
+template <typename FeatureEvaluatorType>
+BaseIteratedWidthDriver<FeatureEvaluatorType>::~BaseIteratedWidthDriver() {}
 
+template <typename FeatureEvaluatorType>
 void
-IteratedWidthDriver::prepare(const SimpleStateModel& model, const Config& config, const std::string& out_dir) {
-	bfws::FeatureSelector<StateT> selector(ProblemInfo::getInstance());
+BaseIteratedWidthDriver<FeatureEvaluatorType>::prepare(const SimpleStateModel& model, const Config& config, const std::string& out_dir) {
 	_feature_evaluator = std::make_shared<FeatureEvaluatorT>();
-	selector.select(*_feature_evaluator);
+	select_features(*_feature_evaluator);
 	create(config, *_feature_evaluator, model, _stats);
 	//setup_reward_function(config, model.getTask());
 	//LPT_INFO("search", "[IteratedWidthDriver::prepare()(" << this << ")] Pointer to problem associated with engine "
 	//					<< _engine.get() << " is " << &(_engine->_model.getTask()) << " via model " << &model);
 }
 
+template <typename FeatureEvaluatorType>
 void
-IteratedWidthDriver::dispose(/* arguments */) {
+BaseIteratedWidthDriver<FeatureEvaluatorType>::dispose(/* arguments */) {
 	//_engine.reset(nullptr);
 	_engine = nullptr;
 }
 
+template <typename FeatureEvaluatorType>
 ExitCode
-IteratedWidthDriver::search() {
+BaseIteratedWidthDriver<FeatureEvaluatorType>::search() {
 	//LPT_INFO("search", "[IteratedWidthDriver::search()(" << this << ")] Pointer to problem associated with engine "
 	//					<< _engine.get() << " is " << &(_engine->_model.getTask()) << " via model " << &(_engine->_model));
 	if ( _engine.get() == nullptr ) {
 		throw std::runtime_error("[IteratedWidthDriver::search()]: search engine was not prepared!");
 	}
-	LPT_INFO("search", "Resetting search call statistics cached in driver...");
+	if ( !_quiet ) LPT_INFO("search", "Resetting search call statistics cached in driver...");
 	reset_results();
+	if ( _transitions ) _transitions->reset_stats();
 	float start_time = aptk::time_used();
 	try {
-		LPT_INFO("search", "Resetting search engine internal data structures...");
+		if ( !_quiet ) LPT_INFO("search", "Resetting search engine internal data structures...");
 		_engine->reset();
-		LPT_INFO("search", "Search started...");
+		if ( !_quiet ) LPT_INFO("search", "Search started...");
 		solved = _engine->solve_model( plan );
 	}
 	catch (const std::bad_alloc& ex)
 	{
-		LPT_INFO("cout", "FAILED TO ALLOCATE MEMORY");
+		if ( !_quiet ) LPT_INFO("cout", "FAILED TO ALLOCATE MEMORY");
 		oom = true;
 		dispose(); //needs prepare
 	}
@@ -73,8 +75,9 @@ IteratedWidthDriver::search() {
 	return result;
 }
 
+template <typename FeatureEvaluatorType>
 void
-IteratedWidthDriver::create(const Config& config, const IteratedWidthDriver::FeatureEvaluatorT& featureset, const SimpleStateModel& model, lookahead::IteratedWidthStats& stats) {
+BaseIteratedWidthDriver<FeatureEvaluatorType>::create(const Config& config, const FeatureEvaluatorT& featureset, const SimpleStateModel& model, lookahead::IteratedWidthStats& stats) {
 	using FeatureValueT = typename bfws::IntNoveltyEvaluatorI::FeatureValueT;
 
 	unsigned max_novelty = config.getOption<int>("width.max");
@@ -89,45 +92,57 @@ IteratedWidthDriver::create(const Config& config, const IteratedWidthDriver::Fea
 
 	_engine = std::make_unique<EngineT>(model, std::move(featureset), evaluator , cfg, stats, verbose );
 	setup_reward_function(config, model.getTask());
+	setup_transition_cache(config);
+	_engine->set_cancellation_flag(_cancelled);
+	_engine->set_quiet(_quiet);
 	//LPT_INFO("search", "[IteratedWidthDriver::create()(" << this << ")] Pointer to problem associated with engine "
 	//					<< _engine.get() << " is " << &(_engine->_model.getTask()) << " via model " << &model);
 }
 
+template <typename FeatureEvaluatorType>
 void
-IteratedWidthDriver::setup_reward_function( const Config& cfg, const Problem& prob ) {
-	if ( cfg.getOption<bool>("reward.goal_count", false )) {
-		LPT_INFO("search", "Using goal counting reward");
-		std::shared_ptr<Reward> r_func = hybrid::GoalCountSignal::create(prob);
-		_engine->set_reward_function( r_func );
-		return;
-	}
-	if ( cfg.getOption<bool>("reward.goal_error", false )) {
-		LPT_INFO("search", "Using squared goal error reward");
-		std::shared_ptr<Reward> r_func = hybrid::SquaredErrorSignal::create_from_goals(prob);
-		_engine->set_reward_function( r_func );
-		return;
-	}
-	if ( cfg.getOption<bool>("reward.from_metric", false)) {
-		LPT_INFO("search", "Using the specified metric as reward");
-		std::shared_ptr<Reward> r_func = hybrid::StateMetricSignal::create(prob);
-		_engine->set_reward_function( r_func );
-		return;
-	}
+BaseIteratedWidthDriver<FeatureEvaluatorType>::setup_reward_function( const Config& cfg, const Problem& prob ) {
+	_engine->set_reward_function( RewardFunctionFactory::create(cfg, prob) );
+	_engine->set_batch_reward( RewardFunctionFactory::create_batch(cfg, ProblemInfo::getInstance()) );
+}
 
-	throw std::runtime_error("IteratedWidthDriver::setup_reward_function() : No reward function has been specified!");
+template <typename FeatureEvaluatorType>
+void
+BaseIteratedWidthDriver<FeatureEvaluatorType>::setup_transition_cache( const Config& cfg ) {
+	// The cache outlives the engine, so that transitions are shared by all searches
+	if ( _transitions == nullptr )
+		_transitions = lookahead::TransitionCache::create(cfg, ProblemInfo::getInstance());
+	_engine->set_transition_cache( _transitions );
 }
 
 
+template <typename FeatureEvaluatorType>
+void
+BaseIteratedWidthDriver<FeatureEvaluatorType>::set_cancellation_flag( const std::atomic<bool>* flag ) {
+	_cancelled = flag;
+	if ( _engine ) _engine->set_cancellation_flag(flag);
+}
 
+template <typename FeatureEvaluatorType>
+void
+BaseIteratedWidthDriver<FeatureEvaluatorType>::set_quiet( bool quiet ) {
+	_quiet = quiet;
+	if ( _engine ) _engine->set_quiet(quiet);
+}
+
+
+template <typename FeatureEvaluatorType>
 ExitCode
-IteratedWidthDriver::search(const SimpleStateModel& model, const Config& config, const std::string& out_dir, float start_time) {
-	bfws::FeatureSelector<StateT> selector(ProblemInfo::getInstance());
-	return do_search1(model, selector.select(), config, out_dir, start_time);
+BaseIteratedWidthDriver<FeatureEvaluatorType>::search(const SimpleStateModel& model, const Config& config, const std::string& out_dir, float start_time) {
+	FeatureEvaluatorT featureset;
+	select_features(featureset);
+	return do_search1(model, featureset, config, out_dir, start_time);
 }
 
 
+template <typename FeatureEvaluatorType>
 ExitCode
-IteratedWidthDriver::do_search1(const SimpleStateModel& model, const IteratedWidthDriver::FeatureEvaluatorT& featureset, const Config& config, const std::string& out_dir, float start_time) {
+BaseIteratedWidthDriver<FeatureEvaluatorType>::do_search1(const SimpleStateModel& model, const FeatureEvaluatorT& featureset, const Config& config, const std::string& out_dir, float start_time) {
 	create(config, featureset, model, _stats);
 	Utils::SearchExecution<SimpleStateModel> exec_manager(model);
 	EngineOptions opt;
@@ -135,8 +150,9 @@ IteratedWidthDriver::do_search1(const SimpleStateModel& model, const IteratedWid
 	return exec_manager.do_search(*_engine,EngineOptions(), start_time, _stats);
 }
 
+template <typename FeatureEvaluatorType>
 void
-IteratedWidthDriver::archive_scalar_stats( rapidjson::Document& doc ) {
+BaseIteratedWidthDriver<FeatureEvaluatorType>::archive_scalar_stats( rapidjson::Document& doc ) {
 	EmbeddedDriver::archive_scalar_stats(doc);
 	using namespace rapidjson;
     Document::AllocatorType& allocator = doc.GetAllocator();
@@ -145,10 +161,23 @@ IteratedWidthDriver::archive_scalar_stats( rapidjson::Document& doc ) {
 	doc.AddMember( "num_w1_nodes", Value(_stats.num_w1_nodes()).Move(), allocator );
 	doc.AddMember( "num_w2_nodes", Value(_stats.num_w2_nodes()).Move(), allocator );
 	doc.AddMember( "num_wgt2_nodes", Value(_stats.num_wgt2_nodes()).Move(), allocator );
+	doc.AddMember( "num_duplicates", Value((uint64_t) _stats.num_duplicates()).Move(), allocator );
+	doc.AddMember( "num_bound_pruned", Value((uint64_t) _stats.num_bound_pruned()).Move(), allocator );
+	if ( _transitions ) {
+		doc.AddMember( "transition_cache_hits", Value((uint64_t) _transitions->hits()).Move(), allocator );
+		doc.AddMember( "transition_cache_misses", Value((uint64_t) _transitions->misses()).Move(), allocator );
+		doc.AddMember( "transition_cache_size", Value((uint64_t) _transitions->size()).Move(), allocator );
+	}
 	doc.AddMember( "initial_reward", Value(_stats.initial_reward()).Move(), allocator );
 	doc.AddMember( "max_reward", Value(_stats.max_reward()).Move(), allocator );
 	doc.AddMember( "max_depth", Value(_stats.depth_max_reward()).Move(), allocator);
 }
 
 
+// Explicit instantiations
+template class BaseIteratedWidthDriver<lapkt::novelty::GenericFeatureSetEvaluator<SimpleStateModel::StateT>>;
+#ifdef FS_STATIC_STATE_LAYOUT
+template class BaseIteratedWidthDriver<StaticFeatureSetEvaluator<InstanceStateLayout>>;
+#endif
+
 } } } // namespaces
@@ -6,6 +6,7 @@
 
 #include <fs/core/models/simple_state_model.hxx>
 #include <fs/core/search/drivers/sbfws/features/features.hxx>
+#include <search/drivers/online/static_features.hxx>
 
 namespace fs0 { class Config; }
 
@@ -14,13 +15,14 @@ namespace fs0 { namespace drivers { namespace online {
 
 
 //! A creator for an online IW algorithm
-class IteratedWidthDriver : public EmbeddedDriver {
+template <typename FeatureEvaluatorType>
+class BaseIteratedWidthDriver : public EmbeddedDriver {
 public:
     typedef typename SimpleStateModel::StateT
         StateT; // State type
     typedef lookahead::IWNode<SimpleStateModel::StateT,GroundAction>
         NodePT; // Node pointer type
-    typedef lapkt::novelty::GenericFeatureSetEvaluator<StateT>
+    typedef FeatureEvaluatorType
         FeatureEvaluatorT; // Feature evaluator
     typedef lookahead::IW<NodePT, SimpleStateModel, bfws::IntNoveltyEvaluatorI, FeatureEvaluatorT>
         EngineT; // Engine type
@@ -37,7 +39,13 @@ public:
 
     virtual void archive_scalar_stats( rapidjson::Document& doc ) override;
 
-    virtual ~IteratedWidthDriver();
+    //! Make the engine stop as soon as the given flag is raised, returning the best plan found so far
+    void set_cancellation_flag( const std::atomic<bool>* flag );
+
+    //! Do not log anything during the search, so that other drivers can search concurrently
+    void set_quiet( bool quiet );
+
+    virtual ~BaseIteratedWidthDriver();
     EnginePT                                _engine;
 protected:
 	lookahead::IteratedWidthStats _stats;
@@ -51,9 +59,28 @@ protected:
     void
     setup_reward_function( const  Config& cfg, const Problem& prob );
 
+    void
+    setup_transition_cache( const Config& cfg );
+
+    //! The transitions memoized across searches, if enabled
+    std::shared_ptr<lookahead::TransitionCache> _transitions;
+
+    //! The cancellation flag handed to the engine, if any
+    const std::atomic<bool>* _cancelled = nullptr;
+
+    //! Whether the driver and its engine stay silent during the search
+    bool _quiet = false;
+
 
     std::shared_ptr<FeatureEvaluatorT>      _feature_evaluator;
 };
 
+//! The online IW driver, with features selected at run-time from the 'width.*' options ("iw")
+typedef BaseIteratedWidthDriver<lapkt::novelty::GenericFeatureSetEvaluator<SimpleStateModel::StateT>> IteratedWidthDriver;
+
+#ifdef FS_STATIC_STATE_LAYOUT
+//! The online IW driver, with features compiled for the state layout of the instance ("iw.static")
+typedef BaseIteratedWidthDriver<StaticFeatureSetEvaluator<InstanceStateLayout>> StaticIteratedWidthDriver;
+#endif
 
 } } } // namespaces
@@ -0,0 +1,90 @@
+
+#include <search/drivers/online/plan_cache.hxx>
+
+#include <cmath>
+
+#include <fs/core/problem_info.hxx>
+
+namespace fs0 { namespace drivers { namespace online {
+
+PlanCache::PlanCache(unsigned capacity, float default_tolerance) :
+	_capacity(capacity),
+	_default_tolerance(default_tolerance),
+	_hits(0),
+	_misses(0),
+	_rejections(0),
+	_evictions(0)
+{}
+
+void
+PlanCache::set_capacity(unsigned capacity) {
+	_capacity = capacity;
+	clear();
+}
+
+void
+PlanCache::set_default_tolerance(float tol) {
+	_default_tolerance = tol;
+	clear();
+}
+
+void
+PlanCache::set_tolerance(VariableIdx x, float tol) {
+	if ( x >= _tolerances.size() )
+		_tolerances.resize(x + 1, -1.0f);
+	_tolerances[x] = tol;
+	clear();
+}
+
+PlanCache::KeyT
+PlanCache::quantise(const State& s, const ProblemInfo& info) const {
+	KeyT key;
+	key.reserve(info.getNumVariables());
+	for ( VariableIdx x = 0; x < info.getNumVariables(); x++ ) {
+		object_id v = s.getValue(x);
+		float tol = (x < _tolerances.size() && _tolerances[x] >= 0.0f) ? _tolerances[x] : _default_tolerance;
+		if ( info.sv_type(x) == type_id::float_t && tol > 0.0f ) {
+			key.push_back( static_cast<int64_t>(std::floor(fs0::value<float>(v) / tol)) );
+			continue;
+		}
+		key.push_back( static_cast<int64_t>(v.value()) );
+	}
+	return key;
+}
+
+const PlanCache::Entry*
+PlanCache::find(const KeyT& key) {
+	auto it = _index.find(key);
+	if ( it == _index.end() ) {
+		++_misses;
+		return nullptr;
+	}
+	_entries.splice(_entries.begin(), _entries, it->second);
+	return &(it->second->second);
+}
+
+void
+PlanCache::put(const KeyT& key, Entry entry) {
+	if ( !enabled() ) return;
+	auto it = _index.find(key);
+	if ( it != _index.end() ) {
+		it->second->second = std::move(entry);
+		_entries.splice(_entries.begin(), _entries, it->second);
+		return;
+	}
+	if ( _entries.size() >= _capacity ) {
+		_index.erase(_entries.back().first);
+		_entries.pop_back();
+		++_evictions;
+	}
+	_entries.emplace_front(key, std::move(entry));
+	_index.insert(std::make_pair(key, _entries.begin()));
+}
+
+void
+PlanCache::clear() {
+	_index.clear();
+	_entries.clear();
+}
+
+} } } // namespaces
@@ -0,0 +1,95 @@
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+
+#include <fs/core/fs_types.hxx>
+#include <search/drivers/online/plan_rollout.hxx>
+
+namespace fs0 { class ProblemInfo; }
+
+namespace fs0 { namespace drivers { namespace online {
+
+//! A bounded, least-recently-used cache of plans computed in previous planner calls, indexed
+//! by a quantisation of the initial state they were computed for. Entries are not trusted
+//! blindly: the client is expected to re-validate any retrieved plan from the exact new
+//! initial state (see PlanRollout) and report the outcome through 'validated()'.
+class PlanCache {
+public:
+	using PlanT = PlanRollout::PlanT;
+	using KeyT = std::vector<int64_t>;
+
+	struct Entry {
+		//! The plan found for the cached initial state
+		PlanT plan;
+		//! The reward the plan achieved from that state
+		float reward;
+	};
+
+	//! A cache with zero capacity is disabled
+	PlanCache(unsigned capacity = 0, float default_tolerance = 0.0f);
+
+	bool enabled() const { return _capacity > 0; }
+
+	//! Changing the capacity of the cache flushes it
+	void set_capacity(unsigned capacity);
+	unsigned capacity() const { return _capacity; }
+	unsigned size() const { return _entries.size(); }
+
+	//! Quantisation step of each state variable. Float variables with step 0 are hashed by value, and
+	//! so are the variables of any other type, regardless of their tolerance.
+	void set_default_tolerance(float tol);
+	float default_tolerance() const { return _default_tolerance; }
+	void set_tolerance(VariableIdx x, float tol);
+
+	//! Computes the key of state 's'
+	KeyT quantise(const State& s, const ProblemInfo& info) const;
+
+	//! Returns the entry associated to 'key', or nullptr if there is none.
+	//! A successful lookup marks the entry as the most recently used.
+	const Entry* find(const KeyT& key);
+
+	//! Store (or overwrite) the entry for 'key', evicting the least recently used one if necessary
+	void put(const KeyT& key, Entry entry);
+
+	//! The client reports whether the last entry found passed validation
+	void validated(bool valid) { if (valid) ++_hits; else ++_rejections; }
+
+	void clear();
+
+	//! Lookups which returned a plan that was successfully validated
+	unsigned long hits() const { return _hits; }
+	//! Lookups for which no entry was found
+	unsigned long misses() const { return _misses; }
+	//! Lookups which returned a plan that then failed validation
+	unsigned long rejections() const { return _rejections; }
+	unsigned long evictions() const { return _evictions; }
+
+protected:
+	using EntryListT = std::list<std::pair<KeyT, Entry>>;
+	using IndexT = std::unordered_map<KeyT, typename EntryListT::iterator, boost::hash<KeyT>>;
+
+	unsigned _capacity;
+
+	float _default_tolerance;
+
+	//! Per-variable quantisation steps, with negative values standing for "use the default"
+	std::vector<float> _tolerances;
+
+	//! Entries, sorted from most to least recently used
+	EntryListT _entries;
+
+	IndexT _index;
+
+	unsigned long _hits;
+	unsigned long _misses;
+	unsigned long _rejections;
+	unsigned long _evictions;
+};
+
+} } } // namespaces
@@ -0,0 +1,84 @@
+
+#include <search/drivers/online/plan_rollout.hxx>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace fs0 { namespace drivers { namespace online {
+
+float
+RolloutResult::reward() const {
+	float R = terminal;
+	for ( float r : step_rewards ) R += r;
+	return R;
+}
+
+float
+RolloutResult::discounted_reward(float gamma) const {
+	float R = 0.0f, discount = 1.0f;
+	for ( unsigned k = 1; k < step_rewards.size(); k++ ) {
+		discount *= gamma;
+		R += discount * step_rewards[k];
+	}
+	return R + discount * terminal;
+}
+
+PlanRollout::PlanRollout(const SimpleStateModel& model, std::shared_ptr<Reward> reward, std::shared_ptr<lookahead::BatchReward> batch_reward, bool enforce_state_constraints) :
+	_model(model),
+	_reward(reward),
+	_batch_reward(batch_reward),
+	_enforce_state_constraints(enforce_state_constraints)
+{
+	if ( _reward == nullptr )
+		throw std::runtime_error("PlanRollout::PlanRollout() : A reward function is required to score rollouts!");
+}
+
+bool
+PlanRollout::applicable(const State& s, ActionIdT action) const {
+	for (const auto& a : _model.applicable_actions(s, _enforce_state_constraints)) {
+		if ( a == action ) return true;
+	}
+	return false;
+}
+
+float
+PlanRollout::step_reward(const State& s) const {
+	return _batch_reward ? _batch_reward->evaluate(s) : _reward->evaluate(s);
+}
+
+RolloutResult
+PlanRollout::run(const State& s0, const PlanT& plan, unsigned first) const {
+	return simulate(s0, plan, first, plan.size(), 0);
+}
+
+RolloutResult
+PlanRollout::run_sampled(const State& s0, const PlanT& plan, unsigned max_steps, unsigned sample_every) const {
+	return simulate(s0, plan, 0, std::min<std::size_t>(max_steps, plan.size()), sample_every);
+}
+
+RolloutResult
+PlanRollout::simulate(const State& s0, const PlanT& plan, unsigned first, unsigned last, unsigned sample_every) const {
+	RolloutResult result;
+	result.valid = true;
+	result.steps = 0;
+	result.final_state = std::make_shared<State>(s0);
+	result.step_rewards.reserve(last + 1 - std::min(first, last));
+	result.step_rewards.push_back(step_reward(*result.final_state));
+	if ( sample_every > 0 ) result.trajectory.push_back(result.final_state);
+
+	for ( unsigned k = first; k < last; k++ ) {
+		if ( !applicable(*result.final_state, plan[k]) ) {
+			result.valid = false;
+			break;
+		}
+		result.final_state = std::make_shared<State>(_model.next(*result.final_state, plan[k]));
+		result.step_rewards.push_back(step_reward(*result.final_state));
+		result.steps++;
+		if ( sample_every > 0 && result.steps % sample_every == 0 ) result.trajectory.push_back(result.final_state);
+	}
+	if ( sample_every > 0 && result.trajectory.back() != result.final_state ) result.trajectory.push_back(result.final_state);
+	result.terminal = _reward->terminal(*result.final_state);
+	return result;
+}
+
+} } } // namespaces
@@ -0,0 +1,82 @@
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <fs/core/models/simple_state_model.hxx>
+#include <fs/core/heuristics/reward.hxx>
+#include <search/algorithms/lookahead/batch_reward.hxx>
+
+namespace fs0 { namespace drivers { namespace online {
+
+//! The outcome of replaying a sequence of control actions from some given state
+struct RolloutResult {
+	//! Whether every action of the sequence was applicable
+	bool valid;
+
+	//! The number of actions that were actually applied
+	unsigned steps;
+
+	//! r(s_0), ..., r(s_k) for each of the states visited
+	std::vector<float> step_rewards;
+
+	//! T(s_k)
+	float terminal;
+
+	//! The last state reached, s_k
+	std::shared_ptr<State> final_state;
+
+	//! The states sampled along the rollout, if requested (see PlanRollout::run_sampled)
+	std::vector<std::shared_ptr<State>> trajectory;
+
+	//! The (undiscounted) reward accumulated along the rollout, including the terminal cost
+	float reward() const;
+
+	//! As the lookahead engines do, the sum of gamma^k r(s_k) for k = 1, ..., steps, plus the terminal
+	//! cost discounted by gamma^steps. r(s_0) is left out, since it does not depend on the actions.
+	float discounted_reward(float gamma) const;
+};
+
+//! Replays discrete plans (i.e. sequences of action ids, one per discretization step)
+//! over the state model, scoring them with a given reward function. This is the
+//! cheap alternative to running a search when we only need to check that a known plan
+//! is still good from some (new) state. As in the lookahead engines, when a batched reward
+//! is given it computes r(s), and the terminal cost T(s) is still computed by 'reward'.
+class PlanRollout {
+public:
+	using ActionIdT = typename SimpleStateModel::ActionType::IdType;
+	using PlanT = std::vector<ActionIdT>;
+
+	PlanRollout(const SimpleStateModel& model, std::shared_ptr<Reward> reward, std::shared_ptr<lookahead::BatchReward> batch_reward = nullptr, bool enforce_state_constraints = true);
+
+	//! Replay 'plan' from 's0', starting at its 'first'-th action. The rollout stops at the
+	//! first action that is not applicable, in which case the result is flagged as invalid.
+	RolloutResult run(const State& s0, const PlanT& plan, unsigned first = 0) const;
+
+	//! As run(), but applies at most the first 'max_steps' actions of the plan, and, if 'sample_every'
+	//! is non-zero, records s_0 and then every 'sample_every'-th state into the trajectory of the result,
+	//! along with the last state
+	RolloutResult run_sampled(const State& s0, const PlanT& plan, unsigned max_steps, unsigned sample_every) const;
+
+	//! Returns true iff 'action' is applicable on 's'
+	bool applicable(const State& s, ActionIdT action) const;
+
+	const SimpleStateModel& model() const { return _model; }
+
+protected:
+	const SimpleStateModel& _model;
+
+	std::shared_ptr<Reward> _reward;
+
+	std::shared_ptr<lookahead::BatchReward> _batch_reward;
+
+	bool _enforce_state_constraints;
+
+	//! r(s), computed by the batched reward if there is one
+	float step_reward(const State& s) const;
+
+	RolloutResult simulate(const State& s0, const PlanT& plan, unsigned first, unsigned last, unsigned sample_every) const;
+};
+
+} } } // namespaces
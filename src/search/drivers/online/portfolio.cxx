@@ -0,0 +1,230 @@
+
+#include <search/drivers/online/portfolio.hxx>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#include <boost/algorithm/string.hpp>
+
+#include <fs/core/problem.hxx>
+#include <fs/core/problem_info.hxx>
+#include <fs/core/search/drivers/setups.hxx>
+#include <fs/core/utils/config.hxx>
+#include <lapkt/tools/logging.hxx>
+
+#include <search/drivers/online/iterated_width.hxx>
+#include <search/drivers/online/sim_bfws.hxx>
+#include <search/drivers/online/rewards.hxx>
+
+
+namespace fs0 { namespace drivers { namespace online {
+
+PortfolioDriver::~PortfolioDriver() {}
+
+//! Creates a driver of type DriverT whose engine stops when 'flag' is raised, and which stays silent
+//! during the search, since the logger is shared by all threads
+template <typename DriverT>
+static std::unique_ptr<EmbeddedDriver> create_concurrent(const std::atomic<bool>* flag) {
+	auto driver = std::make_unique<DriverT>();
+	driver->set_cancellation_flag(flag);
+	driver->set_quiet(true);
+	return driver;
+}
+
+std::unique_ptr<EmbeddedDriver>
+PortfolioDriver::create_driver(const std::string& name) {
+	if ( name == "iw" ) return create_concurrent<IteratedWidthDriver>(&_cancelled);
+	if ( name == "sbfws" ) return create_concurrent<SimBFWSDriver>(&_cancelled);
+#ifdef FS_STATIC_STATE_LAYOUT
+	if ( name == "iw.static" ) return create_concurrent<StaticIteratedWidthDriver>(&_cancelled);
+	if ( name == "sbfws.static" ) return create_concurrent<StaticSimBFWSDriver>(&_cancelled);
+#endif
+	throw std::runtime_error("[PortfolioDriver::create_driver] : unsupported engine '" + name + "'");
+}
+
+//! The discount factor with which the engine with the given name accumulates rewards
+static float engine_discount(const Config& config, const std::string& name) {
+	if ( boost::starts_with(name, "iw") ) return config.getOption<float>("lookahead.iw.discount_factor", 1.0);
+	return config.getOption<float>("lookahead.bfws.discount", 1.0);
+}
+
+void
+PortfolioDriver::prepare(const SimpleStateModel& model, const Config& config, const std::string& out_dir) {
+	// The engines share the global configuration, so nothing in it may be modified during the search
+	if ( config.getOption<int>("lookahead.schedule.fine_depth", -1) >= 0 )
+		throw std::runtime_error("[PortfolioDriver::prepare] : the integration step schedule cannot be used with concurrent engines");
+
+	std::string names = config.getOption<std::string>("portfolio.engines", "iw,sbfws");
+	std::vector<std::string> tokens;
+	boost::split(tokens, names, boost::is_any_of(","));
+
+	_members.clear();
+	for ( auto& name : tokens ) {
+		boost::trim(name);
+		if ( name.empty() ) continue;
+		for ( const auto& m : _members ) {
+			if ( m.name == name )
+				throw std::runtime_error("[PortfolioDriver::prepare] : engine '" + name + "' listed more than once");
+		}
+		if ( boost::starts_with(name, "iw") && !config.getOption<bool>("lookahead.iw.enforce_state_constraints", true) )
+			throw std::runtime_error("[PortfolioDriver::prepare] : IW cannot disable zero crossing control when run concurrently");
+		_members.push_back(Member{ name, create_driver(name), nullptr, ExitCode::UNSOLVABLE, false, 0.0f, 0, nullptr });
+	}
+	if ( _members.empty() )
+		throw std::runtime_error("[PortfolioDriver::prepare] : option 'portfolio.engines' lists no engine");
+
+	// Unless given, the discount of the candidate plans is that of the engines, which must then agree on it
+	_discount = config.getOption<float>("portfolio.discount", -1.0);
+	if ( _discount < 0.0 ) {
+		_discount = engine_discount(config, _members[0].name);
+		for ( const auto& m : _members ) {
+			if ( engine_discount(config, m.name) != _discount )
+				throw std::runtime_error("[PortfolioDriver::prepare] : the engines use different discount factors, option 'portfolio.discount' must be set");
+		}
+	}
+
+	// The first engine searches the given model, and each of the rest its own copy, so that no two
+	// threads ever share the model or the reward functions that the drivers create from it
+	for ( unsigned i = 0; i < _members.size(); ++i ) {
+		Member& m = _members[i];
+		if ( i > 0 ) m.model = std::make_shared<SimpleStateModel>(GroundingSetup::fully_ground_simple_model(Problem::getInstance()));
+		LPT_INFO("search", "[PortfolioDriver::prepare] Preparing engine '" << m.name << "'");
+		m.driver->prepare(m.model ? *m.model : model, config, out_dir);
+	}
+
+	_deadline = config.getOption<float>("portfolio.deadline", 0.0);
+	_model = &model;
+	_rollout = std::make_unique<PlanRollout>(model, RewardFunctionFactory::create(config, model.getTask()),
+												RewardFunctionFactory::create_batch(config, ProblemInfo::getInstance()));
+}
+
+void
+PortfolioDriver::dispose() {
+	for ( auto& m : _members ) m.driver->dispose();
+}
+
+void
+PortfolioDriver::run_members() {
+	std::mutex mutex;
+	std::condition_variable done;
+	unsigned num_running = _members.size();
+
+	_cancelled = false;
+	std::vector<std::thread> threads;
+	for ( auto& m : _members ) {
+		m.code = ExitCode::UNSOLVABLE;
+		m.finished = false;
+		m.error = nullptr;
+		threads.emplace_back([this, &m, &mutex, &done, &num_running]() {
+			try {
+				m.code = m.driver->search();
+			} catch (...) {
+				m.error = std::current_exception();
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			m.finished = !_cancelled;
+			--num_running;
+			done.notify_one();
+		});
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		auto all_done = [&num_running]() { return num_running == 0; };
+		if ( _deadline > 0.0 ) {
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<float>(_deadline);
+			if ( !done.wait_until(lock, deadline, all_done) ) _cancelled = true;
+		} else {
+			done.wait(lock, all_done);
+		}
+	}
+	// The engines check the flag once per expansion, so the engines still running return shortly
+	for ( auto& t : threads ) t.join();
+	_cancelled = false;
+}
+
+int
+PortfolioDriver::score_plans() {
+	// Plans of different lengths are only comparable over the length of the shortest one, beyond
+	// which the longer plans would just collect more reward terms
+	std::vector<RolloutResult> results(_members.size());
+	unsigned horizon = std::numeric_limits<unsigned>::max();
+	for ( unsigned i = 0; i < _members.size(); ++i ) {
+		Member& m = _members[i];
+		m.reward = -std::numeric_limits<float>::infinity();
+		if ( m.error || m.code != ExitCode::PLAN_FOUND ) continue;
+		results[i] = _rollout->run(_model->init(), m.driver->plan);
+		if ( results[i].valid ) horizon = std::min(horizon, results[i].steps);
+	}
+
+	int best = -1;
+	for ( unsigned i = 0; i < _members.size(); ++i ) {
+		Member& m = _members[i];
+		if ( m.error || m.code != ExitCode::PLAN_FOUND || !results[i].valid ) continue;
+		if ( results[i].steps > horizon ) results[i] = _rollout->run_sampled(_model->init(), m.driver->plan, horizon, 0);
+		m.reward = results[i].discounted_reward(_discount);
+		LPT_INFO("search", "[PortfolioDriver::search] Engine '" << m.name << "' " << (m.finished ? "finished" : "was cancelled")
+							<< ", plan length: " << m.driver->plan.size() << ", reward over " << horizon << " steps: " << m.reward);
+		if ( best < 0 || m.reward > _members[best].reward ) best = i;
+	}
+	return best;
+}
+
+ExitCode
+PortfolioDriver::search() {
+	if ( _members.empty() ) {
+		throw std::runtime_error("[PortfolioDriver::search()]: search engines were not prepared!");
+	}
+	reset_results();
+	auto start_time = std::chrono::steady_clock::now();
+	run_members();
+
+	_num_searches++;
+	_winner = score_plans();
+	search_time = std::chrono::duration<float>(std::chrono::steady_clock::now() - start_time).count();
+	total_planning_time = search_time;
+
+	if ( _winner < 0 ) {
+		bool all_oom = true;
+		for ( const auto& m : _members ) {
+			if ( m.error ) std::rethrow_exception(m.error);
+			if ( m.code != ExitCode::OUT_OF_MEMORY ) all_oom = false;
+		}
+		oom = all_oom;
+		return oom ? ExitCode::OUT_OF_MEMORY : ExitCode::UNSOLVABLE;
+	}
+	Member& winner = _members[_winner];
+	winner.wins++;
+	LPT_INFO("search", "[PortfolioDriver::search] Selected plan of engine '" << winner.name << "' (" << winner.wins << "/" << _num_searches << " searches won)");
+	plan = winner.driver->plan;
+	solved = true;
+	return ExitCode::PLAN_FOUND;
+}
+
+ExitCode
+PortfolioDriver::search(const SimpleStateModel& model, const Config& config, const std::string& out_dir, float start_time) {
+	prepare(model, config, out_dir);
+	return search();
+}
+
+void
+PortfolioDriver::archive_scalar_stats( rapidjson::Document& doc ) {
+	EmbeddedDriver::archive_scalar_stats(doc);
+	using namespace rapidjson;
+	Document::AllocatorType& allocator = doc.GetAllocator();
+	std::string winner = ( _winner < 0 ) ? "" : _members[_winner].name;
+	doc.AddMember( "portfolio_winner", Value(winner.c_str(), allocator).Move(), allocator );
+	doc.AddMember( "portfolio_searches", Value(_num_searches).Move(), allocator );
+	for ( const auto& m : _members ) {
+		doc.AddMember( Value(("portfolio_wins_" + m.name).c_str(), allocator).Move(), Value(m.wins).Move(), allocator );
+		doc.AddMember( Value(("portfolio_finished_" + m.name).c_str(), allocator).Move(), Value(m.finished).Move(), allocator );
+		float reward = std::max(m.reward, -100000.0f); // Keep the document valid JSON
+		doc.AddMember( Value(("portfolio_reward_" + m.name).c_str(), allocator).Move(), Value(reward).Move(), allocator );
+	}
+}
+
+} } } // namespaces
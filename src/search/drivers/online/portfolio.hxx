@@ -0,0 +1,93 @@
+
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fs/core/search/drivers/base.hxx>
+#include <fs/core/models/simple_state_model.hxx>
+
+#include <search/drivers/online/plan_rollout.hxx>
+
+namespace fs0 { class Config; }
+
+namespace fs0 { namespace drivers { namespace online {
+
+//! Runs several online drivers concurrently, each on its own thread and over its own copy of the
+//! model, and returns the plan with the highest reward. The engines are configured with the option
+//! 'portfolio.engines', a comma-separated list of driver names (default "iw,sbfws"). When the
+//! deadline 'portfolio.deadline' (in seconds, 0 for none) expires, the engines still running are
+//! cancelled and contribute the best plan they found so far. Since the engines score their
+//! nodes differently, candidate plans are compared by replaying them from the initial state, over
+//! the length of the shortest one and with a common discount factor.
+class PortfolioDriver : public EmbeddedDriver {
+public:
+	using PlanT = PlanRollout::PlanT;
+
+	virtual void prepare(const SimpleStateModel& model, const Config& config, const std::string& out_dir) override;
+
+	virtual void dispose() override;
+
+	virtual ExitCode search() override;
+
+	virtual ExitCode search(const SimpleStateModel& model, const Config& config, const std::string& out_dir, float start_time) override;
+
+	virtual void archive_scalar_stats( rapidjson::Document& doc ) override;
+
+	virtual ~PortfolioDriver();
+
+protected:
+	//! One of the engines of the portfolio, along with the outcome of its last search
+	struct Member {
+		std::string name;
+		std::unique_ptr<EmbeddedDriver> driver;
+		//! The model searched by the engine, if it is not the model the portfolio was prepared with
+		std::shared_ptr<SimpleStateModel> model;
+		ExitCode code;
+		//! Whether the engine finished before the deadline
+		bool finished;
+		//! The score of the plan returned by the engine, if any
+		float reward;
+		//! The number of searches in which the plan of the engine was selected
+		unsigned wins;
+		//! The exception raised by the engine, if any
+		std::exception_ptr error;
+	};
+
+	std::vector<Member> _members;
+
+	//! Raised when the deadline expires
+	std::atomic<bool> _cancelled{false};
+
+	//! The deadline, in seconds
+	float _deadline = 0.0f;
+
+	//! The discount factor of the rewards of the candidate plans
+	float _discount = 1.0f;
+
+	//! Replays the plans of the engines to compare them
+	std::unique_ptr<PlanRollout> _rollout;
+
+	const SimpleStateModel* _model = nullptr;
+
+	//! The index of the member whose plan was selected in the last search, if any
+	int _winner = -1;
+
+	unsigned _num_searches = 0;
+
+	//! Creates the driver with the given name, which will stop when '_cancelled' is raised, and
+	//! which does not log anything while searching
+	std::unique_ptr<EmbeddedDriver> create_driver(const std::string& name);
+
+	//! Runs all the engines until they finish or the deadline expires
+	void run_members();
+
+	//! Sets the score of the plans of the engines, and returns the index of the best one, or -1 if none
+	int score_plans();
+};
+
+} } } // namespaces
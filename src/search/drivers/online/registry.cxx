@@ -9,30 +9,43 @@
 #include <search/drivers/online/registry.hxx>
 #include <search/drivers/online/iterated_width.hxx>
 #include <search/drivers/online/sim_bfws.hxx>
+#include <search/drivers/online/portfolio.hxx>
 // using namespace fs0::gecode;
 
 namespace fs0 { namespace drivers { namespace online {
 
+//! A factory for drivers of type DriverT
+template <typename DriverT>
+static EngineRegistry::FactoryT factory() { return []() -> EmbeddedDriver* { return new DriverT(); }; }
+
 EngineRegistry::EngineRegistry() {
 	// We register the pre-configured search drivers on the instantiation of the singleton
-	add("iw",  new IteratedWidthDriver());
-	add("sbfws",  new SimBFWSDriver());
+	add("iw",  factory<IteratedWidthDriver>());
+	add("sbfws",  factory<SimBFWSDriver>());
+	add("portfolio",  factory<PortfolioDriver>());
+#ifdef FS_STATIC_STATE_LAYOUT
+	// Drivers specialised for the state layout of the instance the planner was compiled for
+	add("iw.static",  factory<StaticIteratedWidthDriver>());
+	add("sbfws.static",  factory<StaticSimBFWSDriver>());
+#endif
 }
 
-EngineRegistry::~EngineRegistry() {
-	for (const auto elem:_creators) delete elem.second;
-}
+EngineRegistry::~EngineRegistry() {}
 
-void EngineRegistry::add(const std::string& engine_name, EmbeddedDriver* creator) {
-auto res = _creators.insert(std::make_pair(engine_name, creator));
-	if (!res.second) throw new std::runtime_error("Duplicate registration of engine creator for symbol " + engine_name);
+void EngineRegistry::add(const std::string& engine_name, FactoryT factory) {
+auto res = _factories.insert(std::make_pair(engine_name, std::move(factory)));
+	if (!res.second) throw std::runtime_error("Duplicate registration of engine creator for symbol " + engine_name);
 }
 
 
 EmbeddedDriver* EngineRegistry::get(const std::string& engine_name) {
-	auto it = _creators.find(engine_name);
-	if (it == _creators.end()) throw std::runtime_error("No engine creator has been registered for given engine name '" + engine_name + "'");
-	return it->second;
+	auto created = _creators.find(engine_name);
+	if (created != _creators.end()) return created->second.get();
+	auto it = _factories.find(engine_name);
+	if (it == _factories.end()) throw std::runtime_error("No engine creator has been registered for given engine name '" + engine_name + "'");
+	EmbeddedDriver* driver = it->second();
+	_creators[engine_name] = std::unique_ptr<EmbeddedDriver>(driver);
+	return driver;
 }
 
 
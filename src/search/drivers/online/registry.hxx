@@ -1,6 +1,7 @@
 
 #pragma once
 
+#include <functional>
 #include <unordered_map>
 #include <fs/core/search/drivers/base.hxx>
 #include <memory>
@@ -12,19 +13,24 @@ namespace fs0 {
 
 namespace fs0 { namespace drivers { namespace online {
 
-//! A registry for different types of search drivers
+//! A registry for different types of search drivers. Drivers are only created the
+//! first time they are requested, since each of them may hold large data structures.
 class EngineRegistry {
 public:
+	using FactoryT = std::function<EmbeddedDriver*()>;
+
 	~EngineRegistry();
 	//! Register a new engine creator responsible for creating drivers with the given engine_name
-	void add(const std::string& engine_name, EmbeddedDriver* creator);
+	void add(const std::string& engine_name, FactoryT factory);
 
-	//! Retrieve the engine creater adequate for the given engine name
+	//! Retrieve the engine creater adequate for the given engine name, creating it if necessary
 	EmbeddedDriver* get(const std::string& engine_name);
 
 	EngineRegistry();
 protected:
-	std::unordered_map<std::string, EmbeddedDriver*>	 _creators;
+	std::unordered_map<std::string, FactoryT>	 _factories;
+
+	std::unordered_map<std::string, std::unique_ptr<EmbeddedDriver>>	 _creators;
 };
 
 } } }// namespaces
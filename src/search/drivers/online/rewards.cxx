@@ -0,0 +1,89 @@
+
+#include <search/drivers/online/rewards.hxx>
+
+#include <boost/algorithm/string.hpp>
+
+#include <fs/core/problem.hxx>
+#include <fs/core/problem_info.hxx>
+#include <fs/core/utils/config.hxx>
+#include <lapkt/tools/logging.hxx>
+
+#include <fs/core/heuristics/goal_count_signal.hxx>
+#include <fs/core/heuristics/error_signal.hxx>
+#include <fs/core/heuristics/metric_signal.hxx>
+
+#include <utils/external_batch.hxx>
+
+namespace fs0 { namespace drivers { namespace online {
+
+std::shared_ptr<Reward>
+RewardFunctionFactory::create( const Config& cfg, const Problem& prob ) {
+	if ( cfg.getOption<bool>("reward.goal_count", false )) {
+		LPT_INFO("search", "Using goal counting reward");
+		return hybrid::GoalCountSignal::create(prob);
+	}
+	if ( cfg.getOption<bool>("reward.goal_error", false )) {
+		LPT_INFO("search", "Using squared goal error reward");
+		return hybrid::SquaredErrorSignal::create_from_goals(prob);
+	}
+	if ( cfg.getOption<bool>("reward.from_metric", false)) {
+		LPT_INFO("search", "Using the specified metric as reward");
+		return hybrid::StateMetricSignal::create(prob);
+	}
+
+	throw std::runtime_error("RewardFunctionFactory::create() : No reward function has been specified!");
+}
+
+std::shared_ptr<lookahead::BatchReward>
+RewardFunctionFactory::create_batch( const Config& cfg, const ProblemInfo& info ) {
+	std::string function = cfg.getOption<std::string>("reward.external_batch", "");
+	if ( function.empty() ) return nullptr;
+
+	const ExternalBatchEvaluator* evaluator = ExternalBatchEvaluator::instance();
+	if ( evaluator == nullptr )
+		throw std::runtime_error("RewardFunctionFactory::create_batch() : option 'reward.external_batch' requires an external library exporting the symbol '"
+									+ std::string(ExternalBatchEvaluator::symbol_name()) + "'");
+
+	// By default, the reward is a function of the whole state
+	std::vector<VariableIdx> arguments;
+	std::string names = cfg.getOption<std::string>("reward.external_batch_args", "");
+	if ( names.empty() ) {
+		for ( VariableIdx x = 0; x < info.getNumVariables(); x++ ) arguments.push_back(x);
+	} else {
+		std::vector<std::string> tokens;
+		boost::split(tokens, names, boost::is_any_of(","));
+		for ( auto& name : tokens ) {
+			boost::trim(name);
+			arguments.push_back(info.getVariableId(name));
+		}
+	}
+	LPT_INFO("search", "Using batched external reward '" << function << "' over " << arguments.size() << " state variables");
+	return std::make_shared<ExternalBatchReward>(*evaluator, function, arguments, info);
+}
+
+ExternalBatchReward::ExternalBatchReward( const ExternalBatchEvaluator& evaluator, const std::string& function, const std::vector<VariableIdx>& arguments, const ProblemInfo& info ) :
+	_evaluator(evaluator),
+	_function(function),
+	_arguments(arguments)
+{
+	if ( _arguments.empty() )
+		throw std::runtime_error("ExternalBatchReward::ExternalBatchReward() : the batched reward '" + function + "' needs at least one argument");
+	for ( VariableIdx x : _arguments )
+		_is_float.push_back(info.sv_type(x) == type_id::float_t);
+}
+
+void
+ExternalBatchReward::evaluate(const std::vector<const State*>& states, std::vector<float>& rewards) {
+	const unsigned arity = _arguments.size();
+	_buffer.resize(states.size() * arity);
+	unsigned k = 0;
+	for ( const State* s : states ) {
+		for ( unsigned i = 0; i < arity; i++ ) {
+			object_id v = s->getValue(_arguments[i]);
+			_buffer[k++] = _is_float[i] ? fs0::value<float>(v) : static_cast<float>(v.value());
+		}
+	}
+	_evaluator.evaluate(_function, arity, _buffer, rewards);
+}
+
+} } } // namespaces
@@ -0,0 +1,57 @@
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fs/core/fs_types.hxx>
+#include <fs/core/heuristics/reward.hxx>
+#include <search/algorithms/lookahead/batch_reward.hxx>
+
+namespace fs0 {
+	class Config;
+	class Problem;
+	class ProblemInfo;
+	class ExternalBatchEvaluator;
+}
+
+namespace fs0 { namespace drivers { namespace online {
+
+//! Creates the reward function selected by the 'reward.*' planner options. Shared by
+//! the lookahead drivers and by the runner, so that plans produced by different engines
+//! (or retrieved from caches) are all scored against the same signal.
+class RewardFunctionFactory {
+public:
+	//! Throws if no reward function has been specified
+	static std::shared_ptr<Reward> create( const Config& cfg, const Problem& prob );
+
+	//! Returns the batched reward selected by the 'reward.external_batch' option, or nullptr
+	//! if none was selected
+	static std::shared_ptr<lookahead::BatchReward> create_batch( const Config& cfg, const ProblemInfo& info );
+};
+
+//! A batched reward computed by an external library function (see ExternalBatchEvaluator)
+//! whose arguments are the values of a fixed list of state variables.
+class ExternalBatchReward : public lookahead::BatchReward {
+public:
+	ExternalBatchReward( const ExternalBatchEvaluator& evaluator, const std::string& function, const std::vector<VariableIdx>& arguments, const ProblemInfo& info );
+
+	using lookahead::BatchReward::evaluate;
+	void evaluate(const std::vector<const State*>& states, std::vector<float>& rewards) override;
+
+protected:
+	const ExternalBatchEvaluator& _evaluator;
+
+	std::string _function;
+
+	std::vector<VariableIdx> _arguments;
+
+	//! Whether each of the arguments is a float variable
+	std::vector<bool> _is_float;
+
+	//! The buffer where the argument tuples are laid out
+	std::vector<float> _buffer;
+};
+
+} } } // namespaces
@@ -6,9 +6,7 @@
 #include <fs/core/search/drivers/setups.hxx>
 #include <fs/core/search/utils.hxx>
 
-#include <fs/core/heuristics/goal_count_signal.hxx>
-#include <fs/core/heuristics/error_signal.hxx>
-#include <fs/core/heuristics/metric_signal.hxx>
+#include <search/drivers/online/rewards.hxx>
 
 #include <fs/core/search/novelty/fs_novelty.hxx>
 
@@ -17,46 +15,50 @@
 
 namespace fs0 { namespace drivers { namespace online {
 
-SimBFWSDriver::~SimBFWSDriver() {}
+template <typename FeatureEvaluatorType>
+BaseSimBFWSDriver<FeatureEvaluatorType>::~BaseSimBFWSDriver() {}
 
+template <typename FeatureEvaluatorType>
 void
-SimBFWSDriver::prepare(const SimpleStateModel& model, const Config& config, const std::string& out_dir) {
-	bfws::FeatureSelector<StateT> selector(ProblemInfo::getInstance());
+BaseSimBFWSDriver<FeatureEvaluatorType>::prepare(const SimpleStateModel& model, const Config& config, const std::string& out_dir) {
 	_feature_evaluator = std::make_shared<FeatureEvaluatorT>();
-	selector.select(*_feature_evaluator);
+	select_features(*_feature_evaluator);
 	create(config, model, _stats);
 	//setup_reward_function(config, model.getTask());
 	//LPT_INFO("search", "[SimBFWSDriver::prepare()(" << this << ")] Pointer to problem associated with engine "
 	//					<< _engine.get() << " is " << &(_engine->_model.getTask()) << " via model " << &model);
 }
 
+template <typename FeatureEvaluatorType>
 void
-SimBFWSDriver::dispose(/* arguments */) {
+BaseSimBFWSDriver<FeatureEvaluatorType>::dispose(/* arguments */) {
 	//_engine.reset(nullptr);
 	_engine = nullptr;
 }
 
+template <typename FeatureEvaluatorType>
 ExitCode
-SimBFWSDriver::search() {
+BaseSimBFWSDriver<FeatureEvaluatorType>::search() {
 	//LPT_INFO("search", "[SimBFWSDriver::search()(" << this << ")] Pointer to problem associated with engine "
 	//					<< _engine.get() << " is " << &(_engine->_model.getTask()) << " via model " << &(_engine->_model));
 	if ( _engine.get() == nullptr ) {
 		throw std::runtime_error("[SimBFWSDriver::search()]: search engine was not prepared!");
 	}
-	LPT_INFO("search", "Resetting search call statistics cached in driver...");
+	if ( !_quiet ) LPT_INFO("search", "Resetting search call statistics cached in driver...");
 	reset_results();
+	if ( _transitions ) _transitions->reset_stats();
 	float start_time = aptk::time_used();
 	try {
-		LPT_INFO("search", "Resetting search engine internal data structures...");
+		if ( !_quiet ) LPT_INFO("search", "Resetting search engine internal data structures...");
         // MRJ: BFWS doesn't have a reset function, do we need one?
 		//_engine->reset();
-		LPT_INFO("search", "Search started...");
+		if ( !_quiet ) LPT_INFO("search", "Search started...");
 		solved = _engine->solve_model( plan );
-		LPT_INFO("search", "Search finished normally...")
+		if ( !_quiet ) LPT_INFO("search", "Search finished normally...")
 	}
 	catch (const std::bad_alloc& ex)
 	{
-		LPT_INFO("cout", "FAILED TO ALLOCATE MEMORY");
+		if ( !_quiet ) LPT_INFO("cout", "FAILED TO ALLOCATE MEMORY");
 		oom = true;
 		dispose(); //needs prepare
 	}
@@ -75,8 +77,9 @@ SimBFWSDriver::search() {
 	return result;
 }
 
+template <typename FeatureEvaluatorType>
 void
-SimBFWSDriver::create(const Config& config, const SimpleStateModel& model, bfws::BFWSStats& stats) {
+BaseSimBFWSDriver<FeatureEvaluatorType>::create(const Config& config, const SimpleStateModel& model, bfws::BFWSStats& stats) {
 	//using FeatureValueT = typename bfws::IntNoveltyEvaluatorI::FeatureValueT;
     bfws::SBFWSConfig bfws_config(config);
 
@@ -86,47 +89,57 @@ SimBFWSDriver::create(const Config& config, const SimpleStateModel& model, bfws:
 
 	_engine = std::make_unique<EngineT>(model, std::move(*_feature_evaluator), stats, config, bfws_config );
 	setup_reward_function(config, model.getTask());
+	setup_transition_cache(config);
+	_engine->set_cancellation_flag(_cancelled);
+	_engine->set_quiet(_quiet);
 	//LPT_INFO("search", "[SimBFWSDriver::create()(" << this << ")] Pointer to problem associated with engine "
 	//					<< _engine.get() << " is " << &(_engine->_model.getTask()) << " via model " << &model);
 }
 
+template <typename FeatureEvaluatorType>
 void
-SimBFWSDriver::setup_reward_function( const Config& cfg, const Problem& prob ) {
-	if ( cfg.getOption<bool>("reward.goal_count", false )) {
-		LPT_INFO("search", "Using goal counting reward");
-		std::shared_ptr<Reward> r_func = hybrid::GoalCountSignal::create(prob);
-		_engine->set_reward_function( r_func );
-		return;
-	}
-	if ( cfg.getOption<bool>("reward.goal_error", false )) {
-		LPT_INFO("search", "Using squared goal error reward");
-		std::shared_ptr<Reward> r_func = hybrid::SquaredErrorSignal::create_from_goals(prob);
-		_engine->set_reward_function( r_func );
-		return;
-	}
-	if ( cfg.getOption<bool>("reward.from_metric", false)) {
-		LPT_INFO("search", "Using the specified metric as reward");
-		std::shared_ptr<Reward> r_func = hybrid::StateMetricSignal::create(prob);
-		_engine->set_reward_function( r_func );
-		return;
-	}
+BaseSimBFWSDriver<FeatureEvaluatorType>::setup_reward_function( const Config& cfg, const Problem& prob ) {
+	_engine->set_reward_function( RewardFunctionFactory::create(cfg, prob) );
+	_engine->set_batch_reward( RewardFunctionFactory::create_batch(cfg, ProblemInfo::getInstance()) );
+}
 
-	throw std::runtime_error("SimBFWSDriver::setup_reward_function() : No reward function has been specified!");
+template <typename FeatureEvaluatorType>
+void
+BaseSimBFWSDriver<FeatureEvaluatorType>::setup_transition_cache( const Config& cfg ) {
+	// The cache outlives the engine, so that transitions are shared by all searches
+	if ( _transitions == nullptr )
+		_transitions = lookahead::TransitionCache::create(cfg, ProblemInfo::getInstance());
+	_engine->set_transition_cache( _transitions );
 }
 
 
+template <typename FeatureEvaluatorType>
+void
+BaseSimBFWSDriver<FeatureEvaluatorType>::set_cancellation_flag( const std::atomic<bool>* flag ) {
+	_cancelled = flag;
+	if ( _engine ) _engine->set_cancellation_flag(flag);
+}
 
+template <typename FeatureEvaluatorType>
+void
+BaseSimBFWSDriver<FeatureEvaluatorType>::set_quiet( bool quiet ) {
+	_quiet = quiet;
+	if ( _engine ) _engine->set_quiet(quiet);
+}
+
+
+template <typename FeatureEvaluatorType>
 ExitCode
-SimBFWSDriver::search(const SimpleStateModel& model, const Config& config, const std::string& out_dir, float start_time) {
-	bfws::FeatureSelector<StateT> selector(ProblemInfo::getInstance());
+BaseSimBFWSDriver<FeatureEvaluatorType>::search(const SimpleStateModel& model, const Config& config, const std::string& out_dir, float start_time) {
     _feature_evaluator = std::make_shared<FeatureEvaluatorT>();
-	selector.select(*_feature_evaluator);
+	select_features(*_feature_evaluator);
 	return do_search1(model, config, out_dir, start_time);
 }
 
 
+template <typename FeatureEvaluatorType>
 ExitCode
-SimBFWSDriver::do_search1(const SimpleStateModel& model, const Config& config, const std::string& out_dir, float start_time) {
+BaseSimBFWSDriver<FeatureEvaluatorType>::do_search1(const SimpleStateModel& model, const Config& config, const std::string& out_dir, float start_time) {
 	create(config,  model, _stats);
 	Utils::SearchExecution<SimpleStateModel> exec_manager(model);
 
@@ -135,8 +148,9 @@ SimBFWSDriver::do_search1(const SimpleStateModel& model, const Config& config, c
 	return exec_manager.do_search(*_engine, opt, start_time, _stats);
 }
 
+template <typename FeatureEvaluatorType>
 void
-SimBFWSDriver::archive_scalar_stats( rapidjson::Document& doc ) {
+BaseSimBFWSDriver<FeatureEvaluatorType>::archive_scalar_stats( rapidjson::Document& doc ) {
 	EmbeddedDriver::archive_scalar_stats(doc);
 	using namespace rapidjson;
     Document::AllocatorType& allocator = doc.GetAllocator();
@@ -146,6 +160,13 @@ SimBFWSDriver::archive_scalar_stats( rapidjson::Document& doc ) {
 	doc.AddMember( "num_wgr1_nodes", Value(_stats.num_wgr1_nodes()).Move(), allocator );
     doc.AddMember( "num_wgr2_nodes", Value(_stats.num_wgr2_nodes()).Move(), allocator );
 	doc.AddMember( "num_wgr_wgt2_nodes", Value(_stats.num_wgr_gt2_nodes()).Move(), allocator );
+	doc.AddMember( "num_shared_R", Value((uint64_t) _engine->get_heuristic().num_shared_R()).Move(), allocator );
+	doc.AddMember( "num_bound_pruned", Value((uint64_t) _engine->num_bound_pruned()).Move(), allocator );
+	if ( _transitions ) {
+		doc.AddMember( "transition_cache_hits", Value((uint64_t) _transitions->hits()).Move(), allocator );
+		doc.AddMember( "transition_cache_misses", Value((uint64_t) _transitions->misses()).Move(), allocator );
+		doc.AddMember( "transition_cache_size", Value((uint64_t) _transitions->size()).Move(), allocator );
+	}
 	doc.AddMember( "initial_reward", Value(_stats.initial_reward()).Move(), allocator );
 	float selected_reward = _engine->get_best_node() ? _engine->get_best_node()->R : -100000.0;
 	doc.AddMember( "max_reward", Value(selected_reward).Move(), allocator );
@@ -154,4 +175,10 @@ SimBFWSDriver::archive_scalar_stats( rapidjson::Document& doc ) {
 }
 
 
+// Explicit instantiations
+template class BaseSimBFWSDriver<lapkt::novelty::GenericFeatureSetEvaluator<SimpleStateModel::StateT>>;
+#ifdef FS_STATIC_STATE_LAYOUT
+template class BaseSimBFWSDriver<StaticFeatureSetEvaluator<InstanceStateLayout>>;
+#endif
+
 } } } // namespaces
@@ -0,0 +1,125 @@
+
+#pragma once
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fs/core/problem.hxx>
+#include <fs/core/problem_info.hxx>
+#include <fs/core/search/drivers/sbfws/features/features.hxx>
+#include <lapkt/novelty/features.hxx>
+
+// The per-instance state layout is generated by 'tools/generate_state_layout.py' into the
+// instance directory, where SConstruct picks it up and defines FS_STATIC_STATE_LAYOUT
+#ifdef FS_STATIC_STATE_LAYOUT
+#include <state_layout.hxx>
+#endif
+
+namespace fs0 { namespace drivers { namespace online {
+
+//! A feature set evaluator whose features are exactly the state variables of a fixed,
+//! compile-time layout, generated for a particular problem instance. The valuation of a
+//! state is extracted with a fully unrolled, branch-free sequence of reads, in contrast to
+//! the per-feature virtual calls of lapkt::novelty::GenericFeatureSetEvaluator.
+//! 'LayoutT' must provide 'num_variables' and, for each index I, 'variable<I>::type' and
+//! 'variable<I>::name()'. The features are only valid if they are the ones the 'width.*' options
+//! select, which is checked against the FeatureSelector by select_features().
+template <typename LayoutT>
+class StaticFeatureSetEvaluator {
+public:
+	using FeatureValueT = lapkt::novelty::FeatureValueT;
+	using ValuationT = std::array<FeatureValueT, LayoutT::num_variables>;
+
+	static constexpr unsigned NumFeatures = LayoutT::num_variables;
+
+	ValuationT evaluate(const State& state) const {
+		ValuationT valuation;
+		fill(state, valuation, std::make_index_sequence<NumFeatures>());
+		return valuation;
+	}
+
+	//! Fills the valuation of 'state' in place, for the novelty tables, which work on vectors
+	template <typename ValueT>
+	void evaluate(const State& state, std::vector<ValueT>& valuation) const {
+		valuation.resize(NumFeatures);
+		fill(state, valuation, std::make_index_sequence<NumFeatures>());
+	}
+
+	unsigned size() const { return NumFeatures; }
+
+	//! Feature values are raw state variable values and thus do not map to problem atoms
+	bool uses_extra_features() const { return true; }
+
+	//! Throws if the layout the evaluator was compiled with does not match the loaded problem
+	void check_layout(const ProblemInfo& info) const {
+		if ( info.getNumVariables() != NumFeatures )
+			throw std::runtime_error("StaticFeatureSetEvaluator::check_layout() : compiled layout has " + std::to_string(NumFeatures)
+										+ " state variables, but the problem has " + std::to_string(info.getNumVariables()));
+		check(info, std::make_index_sequence<NumFeatures>());
+	}
+
+	//! Throws if the features of 'selected', as chosen by the FeatureSelector, do not evaluate
+	//! exactly as the compiled ones on 's', e.g. because the 'width.*' options select features
+	//! other than the state variables, or encode some of them differently
+	template <typename FeatureSetT>
+	void check_selection(const FeatureSetT& selected, const State& s) const {
+		auto expected = selected.evaluate(s);
+		if ( expected.size() != NumFeatures )
+			throw std::runtime_error("StaticFeatureSetEvaluator::check_selection() : the 'width.*' options select " + std::to_string(expected.size())
+										+ " features, but the compiled layout only provides the " + std::to_string(NumFeatures) + " state variables");
+		ValuationT valuation = evaluate(s);
+		for ( unsigned i = 0; i < NumFeatures; i++ ) {
+			if ( expected[i] != valuation[i] )
+				throw std::runtime_error("StaticFeatureSetEvaluator::check_selection() : feature #" + std::to_string(i)
+											+ " selected by the 'width.*' options is not the value of state variable #" + std::to_string(i));
+		}
+	}
+
+protected:
+	template <typename ContainerT, std::size_t... I>
+	static void fill(const State& state, ContainerT& valuation, std::index_sequence<I...>) {
+		using expander = int[];
+		(void) expander{ 0, (valuation[I] = static_cast<FeatureValueT>(state.getValue(I).value()), 0)... };
+	}
+
+	template <std::size_t... I>
+	static void check(const ProblemInfo& info, std::index_sequence<I...>) {
+		using expander = int[];
+		(void) expander{ 0, (check_variable<I>(info), 0)... };
+	}
+
+	template <std::size_t I>
+	static void check_variable(const ProblemInfo& info) {
+		using VariableT = typename LayoutT::template variable<I>;
+		if ( info.getVariableName(I) != VariableT::name() || info.sv_type(I) != VariableT::type )
+			throw std::runtime_error("StaticFeatureSetEvaluator::check_layout() : state variable #" + std::to_string(I) + " '"
+										+ info.getVariableName(I) + "' does not match compiled layout ('" + VariableT::name() + "')");
+	}
+};
+
+//! Sets up the features of the generic evaluator with the FeatureSelector, as configured by the 'width.*' options
+inline void select_features(lapkt::novelty::GenericFeatureSetEvaluator<State>& evaluator) {
+	bfws::FeatureSelector<State> selector(ProblemInfo::getInstance());
+	selector.select(evaluator);
+}
+
+//! Static evaluators have their features fixed at compile time, we only check they match the problem
+//! and the features that the FeatureSelector would choose
+template <typename LayoutT>
+void select_features(StaticFeatureSetEvaluator<LayoutT>& evaluator) {
+	evaluator.check_layout(ProblemInfo::getInstance());
+	lapkt::novelty::GenericFeatureSetEvaluator<State> selected;
+	select_features(selected);
+	evaluator.check_selection(selected, Problem::getInstance().getInitialState());
+}
+
+//! Lets the lookahead engines fill their valuation buffers in place (see lookahead::evaluate_features)
+template <typename LayoutT, typename ValueT>
+void evaluate_features(const StaticFeatureSetEvaluator<LayoutT>& features, const State& state, std::vector<ValueT>& valuation) {
+	features.evaluate(state, valuation);
+}
+
+} } } // namespaces
@@ -0,0 +1,25 @@
+
+#include <utils/external_batch.hxx>
+
+#include <stdexcept>
+
+namespace fs0 {
+
+std::unique_ptr<ExternalBatchEvaluator> ExternalBatchEvaluator::_instance = nullptr;
+
+ExternalBatchEvaluator::ExternalBatchEvaluator(ExternalI* instance, SignatureT function) :
+	_external(instance),
+	_function(function)
+{}
+
+void
+ExternalBatchEvaluator::evaluate(const std::string& function, unsigned arity, const std::vector<float>& args, std::vector<float>& results) const {
+	unsigned num_tuples = (arity > 0) ? args.size() / arity : 0;
+	results.resize(num_tuples);
+	if ( num_tuples == 0 ) return;
+	int code = _function(_external, function.c_str(), arity, num_tuples, args.data(), results.data());
+	if ( code != 0 )
+		throw std::runtime_error("[ExternalBatchEvaluator::evaluate] : external function '" + function + "' failed with error code " + std::to_string(code));
+}
+
+} // namespaces
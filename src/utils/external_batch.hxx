@@ -0,0 +1,51 @@
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fs/core/utils/external.hxx>
+
+namespace fs0 {
+
+//! Optional batched calling convention for external libraries. Besides 'create_instance' and
+//! 'destroy_instance', a library may export the symbol
+//!
+//!     extern "C" int evaluate_batch(ExternalI* instance, const char* function,
+//!                                   unsigned arity, unsigned num_tuples,
+//!                                   const float* args, float* results);
+//!
+//! which evaluates the external function named 'function' over 'num_tuples' argument tuples
+//! of size 'arity', laid out contiguously (row-major) in 'args', and writes one value per tuple
+//! into 'results'. A non-zero return value signals an error.
+//!
+//! As with the rest of the planner singletons, the instance is owned by the PythonRunner
+//! and is only made global while one of its methods is executing.
+class ExternalBatchEvaluator {
+public:
+	typedef int (*SignatureT)(ExternalI* instance, const char* function, unsigned arity, unsigned num_tuples, const float* args, float* results);
+
+	//! The name of the optional symbol the external libraries can provide
+	static const char* symbol_name() { return "evaluate_batch"; }
+
+	ExternalBatchEvaluator(ExternalI* instance, SignatureT function);
+
+	//! Evaluates 'function' on each of the 'args.size() / arity' tuples in 'args'
+	void evaluate(const std::string& function, unsigned arity, const std::vector<float>& args, std::vector<float>& results) const;
+
+	//! Singleton management
+	static void set_instance(std::unique_ptr<ExternalBatchEvaluator>&& evaluator) { _instance = std::move(evaluator); }
+	static std::unique_ptr<ExternalBatchEvaluator> claim_ownership() { return std::move(_instance); }
+	//! Returns nullptr if the external library loaded does not support batched calls
+	static ExternalBatchEvaluator* instance() { return _instance.get(); }
+
+protected:
+	ExternalI* _external;
+
+	SignatureT _function;
+
+	static std::unique_ptr<ExternalBatchEvaluator> _instance;
+};
+
+} // namespaces
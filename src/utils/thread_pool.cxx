@@ -0,0 +1,80 @@
+
+#include <utils/thread_pool.hxx>
+
+#include <algorithm>
+
+namespace fs0 {
+
+ThreadPool::ThreadPool(unsigned num_threads) :
+	_task(nullptr),
+	_size(0),
+	_next(0),
+	_busy(0),
+	_generation(0),
+	_stop(false),
+	_error(nullptr)
+{
+	if ( num_threads == 0 ) num_threads = std::max(1u, std::thread::hardware_concurrency());
+	for ( unsigned w = 0; w < num_threads; w++ )
+		_workers.emplace_back(&ThreadPool::work, this, w);
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_start.notify_all();
+	for ( auto& worker : _workers ) worker.join();
+}
+
+void
+ThreadPool::parallel_for(std::size_t n, const TaskT& task) {
+	if ( n == 0 ) return;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_task = &task;
+		_size = n;
+		_next = 0;
+		_busy = _workers.size();
+		_error = nullptr;
+		++_generation;
+	}
+	_start.notify_all();
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	_done.wait(lock, [this] { return _busy == 0; });
+	_task = nullptr;
+	if ( _error ) std::rethrow_exception(_error);
+}
+
+void
+ThreadPool::work(unsigned worker) {
+	uint64_t seen = 0;
+	while ( true ) {
+		const TaskT* task;
+		std::size_t size;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_start.wait(lock, [this, seen] { return _stop || _generation != seen; });
+			if ( _stop ) return;
+			seen = _generation;
+			task = _task;
+			size = _size;
+		}
+
+		for ( std::size_t i = _next++; i < size; i = _next++ ) {
+			try {
+				(*task)(i, worker);
+			} catch (...) {
+				std::lock_guard<std::mutex> lock(_mutex);
+				if ( !_error ) _error = std::current_exception();
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		if ( --_busy == 0 ) _done.notify_all();
+	}
+}
+
+} // namespaces
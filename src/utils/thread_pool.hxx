@@ -0,0 +1,61 @@
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fs0 {
+
+//! A fixed-size pool of worker threads that run batches of independent tasks. Workers are
+//! created once and sleep between batches, so that the cost of spawning threads is not paid
+//! on every call. The pool is meant to be driven from a single thread at a time.
+class ThreadPool {
+public:
+	//! A task receives its index within the batch and the index of the worker running it
+	using TaskT = std::function<void(std::size_t, unsigned)>;
+
+	//! A pool with 0 threads uses as many as the hardware supports
+	explicit ThreadPool(unsigned num_threads = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	unsigned size() const { return _workers.size(); }
+
+	//! Runs task(i, w) for every i in [0, n) and blocks until all of them have finished.
+	//! If some task throws, the first exception is rethrown once the batch is over.
+	void parallel_for(std::size_t n, const TaskT& task);
+
+protected:
+	std::vector<std::thread> _workers;
+
+	std::mutex _mutex;
+	std::condition_variable _start;
+	std::condition_variable _done;
+
+	//! The current batch
+	const TaskT* _task;
+	std::size_t _size;
+	std::atomic<std::size_t> _next;
+
+	//! The number of workers still running the current batch
+	unsigned _busy;
+
+	//! Incremented with every batch, so that workers can tell a new batch from a spurious wakeup
+	uint64_t _generation;
+
+	bool _stop;
+
+	std::exception_ptr _error;
+
+	void work(unsigned worker);
+};
+
+} // namespaces
@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+"""
+Generates the fixed state layout of a problem instance, 'state_layout.hxx', from the
+'problem.json' file produced by the FS front-end for that instance.
+
+When the generated header is placed in the instance directory next to SConstruct, the
+planner library is compiled with the 'iw.static' and 'sbfws.static' search drivers, which
+extract novelty features with a StaticFeatureSetEvaluator specialised for the layout.
+
+Usage: generate_state_layout.py <data_dir> [<output_dir>]
+"""
+
+import json
+import os
+import sys
+
+# The FS builtin types, as understood by fs0::type_id. Any other type must be an object type
+# declared in the 'types' section of the problem specification
+TYPE_IDS = {
+    'bool': 'bool_t',
+    'int': 'int_t',
+    'number': 'float_t',
+    'object': 'object_t',
+}
+
+HEADER = """// Automatically generated by tools/generate_state_layout.py for instance '{instance}'. Do not edit.
+#pragma once
+
+#include <fs/core/fs_types.hxx>
+
+namespace fs0 {{ namespace drivers {{ namespace online {{
+
+struct InstanceStateLayout {{
+\tstatic constexpr unsigned num_variables = {num_variables};
+
+\t//! The name and type of each state variable, in index order
+\ttemplate <unsigned I> struct variable;
+}};
+
+"""
+
+VARIABLE = """template <> struct InstanceStateLayout::variable<{idx}> {{
+\tstatic constexpr type_id type = type_id::{type_id};
+\tstatic const char* name() {{ return "{name}"; }}
+}};
+"""
+
+FOOTER = """
+} } } // namespaces
+"""
+
+
+def type_id(fstype, object_types):
+    """ Returns the fs0::type_id of the given FS type name, failing on undeclared types """
+    if fstype in TYPE_IDS:
+        return TYPE_IDS[fstype]
+    if fstype in object_types:
+        return 'object_t'
+    raise RuntimeError("Unknown type '{}': not a builtin type ({}) nor declared in the problem".format(
+        fstype, ', '.join(sorted(TYPE_IDS))))
+
+
+def load_variables(data):
+    """ Returns the list of (name, type) of the state variables, sorted by their index """
+    try:
+        object_types = {entry['name'] for entry in data['types']}
+        variables = [(entry['id'], entry['name'], type_id(entry['type'], object_types)) for entry in data['variables']]
+    except KeyError as e:
+        raise RuntimeError("Malformed problem specification: missing key {}".format(e))
+    variables.sort()
+    if [v[0] for v in variables] != list(range(len(variables))):
+        raise RuntimeError("State variable indices are not contiguous")
+    return [(name, tid) for _, name, tid in variables]
+
+
+def generate(data_dir, output_dir):
+    with open(os.path.join(data_dir, 'problem.json')) as f:
+        data = json.load(f)
+    variables = load_variables(data)
+    instance = data.get('problem', {}).get('instance', os.path.basename(os.path.normpath(data_dir)))
+
+    with open(os.path.join(output_dir, 'state_layout.hxx'), 'w') as out:
+        out.write(HEADER.format(instance=instance, num_variables=len(variables)))
+        for idx, (name, tid) in enumerate(variables):
+            escaped = name.replace('\\', '\\\\').replace('"', '\\"')
+            out.write(VARIABLE.format(idx=idx, type_id=tid, name=escaped))
+        out.write(FOOTER)
+    print("Generated layout with {} state variables into '{}'".format(len(variables), output_dir))
+
+
+if __name__ == '__main__':
+    if len(sys.argv) not in (2, 3):
+        print(__doc__)
+        sys.exit(1)
+    generate(sys.argv[1], sys.argv[2] if len(sys.argv) == 3 else '.')